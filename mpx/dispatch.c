@@ -0,0 +1,244 @@
+/*!
+ * @file	dispatch.c
+ * @brief	Runs processes on their own stacks, on the host build
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ *
+ * On the PC, sys_req() raises INT 60h, and the system call handler switches
+ * stacks with Turbo C's _SS and _SP.  The host build has neither, so this is
+ * its dispatcher.
+ *
+ * Each process runs on the stack that comes with its PCB.  dispatch_swap()
+ * pushes the registers a function must preserve onto the current stack,
+ * saves the stack pointer, loads another one, and pops that stack's
+ * registers; so a switch is a dozen instructions, and (unlike swapcontext())
+ * makes no system call to save the signal mask.  While a process is not
+ * running, its stack pointer is kept in pcb_cold_t::stack_ptr, with its
+ * registers just above it, much as a PC interrupt handler leaves them on
+ * top of the process's stack.
+ *
+ * dispatch() runs the ready processes, in the order the scheduling policy
+ * chooses, until none is left ready.  A process runs until it calls
+ * sys_req(IDLE), which puts it back in the ready queue as if it had been
+ * preempted after one clock tick (the host has no clock interrupt, so each
+ * turn counts as a tick); or until it calls sys_req(EXIT), or returns from
+ * its function, which ends it and frees its PCB.
+ *
+ * After IDLE, the system call handler passes the CPU straight on to the next
+ * process, on the stack of the one that yielded: a switch is one
+ * dispatch_swap().  Only when a process ends, or none is left ready, does
+ * it go back to the dispatcher's own stack; so a PCB is never freed while
+ * its stack is in use.
+ *
+ * sys_req() only passes IDLE and EXIT on to the dispatcher once sys_init()
+ * has been given MODULE_R3 or later, as main() does on the host.  The
+ * shell's dispatch command runs processes through it.
+ */
+
+
+#include "dispatch.h"
+#include "mpx_supt.h"
+#include <stddef.h>
+
+
+#ifdef DISPATCH_HOST
+
+
+/*! Saves the registers a function must preserve, and the stack pointer in
+ *  \c *save_sp; then loads \c load_sp, and the registers saved on that
+ *  stack, and returns to wherever that stack was saved from.
+ *
+ * The registers are rbp, rbx and r12 through r15 (x86-64 System V); with
+ * the return address, they are the seven words just above a saved stack
+ * pointer.  The floating-point control words are left alone, as every
+ * process shares them.
+ */
+void dispatch_swap( unsigned char **save_sp, unsigned char *load_sp );
+
+__asm__(
+	"	.text\n"
+	"	.globl	dispatch_swap\n"
+	"	.type	dispatch_swap, @function\n"
+	"dispatch_swap:\n"
+	"	pushq	%rbp\n"
+	"	pushq	%rbx\n"
+	"	pushq	%r12\n"
+	"	pushq	%r13\n"
+	"	pushq	%r14\n"
+	"	pushq	%r15\n"
+	"	movq	%rsp, (%rdi)\n"
+	"	movq	%rsi, %rsp\n"
+	"	popq	%r15\n"
+	"	popq	%r14\n"
+	"	popq	%r13\n"
+	"	popq	%r12\n"
+	"	popq	%rbx\n"
+	"	popq	%rbp\n"
+	"	ret\n"
+	"	.size	dispatch_swap, .-dispatch_swap\n"
+);
+
+
+/* The dispatcher's stack pointer, while a process runs. */
+static	unsigned char	*dispatch_sp;
+
+/* The process that is running, or NULL if it is the dispatcher. */
+static	pcb_t		*dispatch_running;
+
+/* A process that has ended, for the dispatcher to free. */
+static	pcb_t		*dispatch_ended;
+
+/* Turns run so far, by all calls to dispatch(). */
+static	unsigned long	 dispatch_turns;
+
+
+/*! The system call handler (see sys_set_vec()): ends the running process's
+ *  turn, and saves its context.  After IDLE, it returns when the process is
+ *  next dispatched.  Device requests are not handled on the host.
+ *
+ * The process goes back in the ready queue (unless it blocked itself), and
+ * the next one is switched to from here.  If that is the same process, the
+ * call simply returns; if there is none, or the process has ended, the
+ * dispatcher takes over.
+ *
+ * @private
+ */
+static void dispatch_call( int op_code, int device_id, char *buf_p,
+	int *count_p )
+{
+	/* The process whose turn it was, and the next one. */
+	pcb_t *pcb = dispatch_running;
+	pcb_t *next;
+
+	if ( pcb == NULL || ( op_code != IDLE && op_code != EXIT ) ){
+		return;
+	}
+
+	dispatch_turns++;
+	advance_sched_clock( 1 );
+
+	if ( op_code == EXIT ){
+		dispatch_ended = pcb;
+		dispatch_running = NULL;
+		dispatch_swap( &pcb->cold->stack_ptr, dispatch_sp );
+		return;
+	}
+
+	if ( pcb->queue_node.queue == NULL ){
+		preempt_pcb( pcb, 1 );
+	}
+	next = dequeue_ready_pcb();
+	if ( next == pcb ){
+		return;
+	}
+
+	dispatch_running = next;
+	dispatch_swap( &pcb->cold->stack_ptr,
+		next == NULL ? dispatch_sp : next->cold->stack_ptr );
+}
+
+
+/*! Where a new process starts: calls its function, and ends it if the
+ *  function returns.
+ *
+ * @private
+ */
+static void dispatch_start( void )
+{
+	int count = 0;
+
+	( (void (*)( void ))dispatch_running->cold->exec_address )();
+	sys_req( EXIT, NO_DEV, NULL, &count );
+}
+
+
+/*! Creates a process that runs a function, and makes it ready.
+ *
+ * Its stack starts out as if dispatch_start() had been called and had then
+ * called dispatch_swap(): a null return address for dispatch_start(), at a
+ * 16-byte boundary as the ABI requires; dispatch_start() as the return
+ * address for dispatch_swap(); and zeroes for the saved registers.
+ *
+ * @return	Returns the new process's handle, or PCB_NO_HANDLE if it could
+ *		not be created (see setup_pcb()).
+ */
+pcb_handle_t create_process(
+	/*! Name of the process; must be unique. */
+	char		*name,
+	/*! Its priority, class and group, as for setup_pcb(). */
+	int		 priority,
+	process_class_t	 class,
+	int		 group,
+	/*! The function it runs.  It ends with sys_req(EXIT), or by
+	 *  returning.  It must keep to STACK_SIZE bytes of stack, less
+	 *  what the scheduling policy takes when it yields. */
+	void		(*entry)( void )
+)
+{
+	pcb_handle_t	 handle = setup_pcb( name, priority, class, group );
+	pcb_t		*pcb = get_pcb( handle );
+	void		**frame;
+
+	if ( pcb == NULL ){
+		return PCB_NO_HANDLE;
+	}
+
+	pcb->cold->exec_address = (unsigned char *)entry;
+
+	frame = (void **)( (size_t)pcb->cold->stack_top & ~(size_t)15 ) - 8;
+	frame[0] = frame[1] = frame[2] = frame[3] = frame[4] = frame[5] = NULL;
+	frame[6] = (void *)dispatch_start;
+	frame[7] = NULL;
+	pcb->cold->stack_ptr = (unsigned char *)frame;
+
+	if ( insert_pcb( pcb ) == NULL ){
+		free_pcb( pcb );
+		return PCB_NO_HANDLE;
+	}
+	return handle;
+}
+
+
+/*! Runs the ready processes until none is left ready.
+ *
+ * Every ready process must have been made by create_process(); a PCB made
+ * by setup_pcb() alone has no stack to switch to.
+ *
+ * Each turn, the process the scheduling policy picks (see
+ * dequeue_ready_pcb()) runs until it makes a system call.  After IDLE, it
+ * goes back in the ready queue with preempt_pcb(), having run for one
+ * clock tick (unless it blocked itself, in which case it is already in the
+ * blocked queue); after EXIT, its PCB is freed.
+ *
+ * @return	Returns the number of turns run, or 0 if it is called from a
+ *		process.
+ */
+unsigned long dispatch( void )
+{
+	/* The process to run. */
+	pcb_t		*pcb;
+	/* Turns run before this call. */
+	unsigned long	 turns = dispatch_turns;
+
+	if ( dispatch_running != NULL ){
+		return 0;
+	}
+	sys_set_vec( dispatch_call );
+
+	while ( ( pcb = dequeue_ready_pcb() ) != NULL ){
+		dispatch_running = pcb;
+		dispatch_swap( &dispatch_sp, pcb->cold->stack_ptr );
+
+		/* Back from a process that ended, or because none was left
+		 * ready. */
+		if ( dispatch_ended != NULL ){
+			free_pcb( dispatch_ended );
+			dispatch_ended = NULL;
+		}
+	}
+
+	return dispatch_turns - turns;
+}
+
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef DISPATCH_H_GUARD
+#define DISPATCH_H_GUARD
+
+/*!
+ * @file	dispatch.h
+ * @brief	Runs processes on their own stacks, on the host build
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ */
+
+
+#include "pcb.h"
+
+
+/*! Defined if this build has dispatch(): a host build (not Turbo C) with
+ *  GCC, on a processor dispatch_swap() is written for.  On the PC, processes
+ *  are dispatched by the INT 60h system call handler instead. */
+#if !defined(__TURBOC__) && defined(__GNUC__) && defined(__x86_64__)
+#define DISPATCH_HOST
+#endif
+
+
+#ifdef DISPATCH_HOST
+pcb_handle_t	create_process	( char *name, int priority,
+				  process_class_t class, int group,
+				  void (*entry)( void ) );
+unsigned long	dispatch	( void );
+#endif
+
+
+#endif
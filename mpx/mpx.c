@@ -14,14 +14,23 @@
 #include "mpx_util.h"
 #include "mpx_sh.h"
 #include "mpx_cmds.h"
+#include "mpx_out.h"
 #include "pcb.h"
+#include "dispatch.h"
+#include <string.h>
 
 
 /*! This is the start-of-execution for the MPX executable. */
 void main(int argc, char *argv[])
 {
-	/* System-specific initialization, provided by support software. */
+	/* System-specific initialization, provided by support software.
+	 * With the host's dispatcher, system calls go to it (see
+	 * dispatch()), as they do from Module R3 on. */
+#ifdef DISPATCH_HOST
+	sys_init( MODULE_R3 );
+#else
 	sys_init( MODULE_R2 );
+#endif
 
 	/* Initialization for MPX user commands. */
 	init_commands();
@@ -29,11 +38,27 @@ void main(int argc, char *argv[])
 	/* Initialization for PCB queues. */
 	init_pcb_queues();
 
-	/* Execute the command-handler loop. */
-	mpx_shell();
+	/* "mpx -S policy ..." picks the scheduling policy. */
+	if ( argc >= 3 && strcmp( argv[1], "-S" ) == 0 ) {
+		if ( ! set_sched_policy( argv[2] ) ) {
+			mpx_printf("WARNING: No scheduling policy '%s'; using '%s'.\n",
+				argv[2], get_sched_policy()->name);
+		}
+		argc -= 2;
+		argv += 2;
+	}
+
+	/* Execute the command-handler loop; or, if invoked as
+	 * "mpx -b [script]", run the script (or standard input) instead. */
+	if ( argc >= 2 && strcmp( argv[1], "-b" ) == 0 ) {
+		mpx_batch( argc >= 3 ? argv[2] : NULL );
+	} else {
+		mpx_shell();
+	}
 
 	/* mpx_shell() should never return, so if we get here, then
 	 * we should exit with error status (but don't actually...). */
-	printf("FATAL ERROR: mpx_shell() returned! That shouldn't happen...\n");
+	mpx_printf("FATAL ERROR: mpx_shell() returned! That shouldn't happen...\n");
+	mpx_flush();
 	sys_exit();	/* Terminate, after doing MPX-specific cleanup. */
 }
@@ -14,18 +14,121 @@
 #include "mpx_cmds.h"
 #include "mpx_supt.h"
 #include "mpx_util.h"
+#include "mpx_sh.h"
+#include "mpx_out.h"
 #include "pcb.h"
+#include "dispatch.h"
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#ifdef __TURBOC__
+#include <io.h>
+#include <fcntl.h>
+#endif
 
-/*! @brief	A linked-list of MPX shell commands
+
+/*! @brief	The table of MPX shell commands, sorted by name.
+ *
+ *  Keeping the table sorted means that all of the commands which start with a
+ *  given abbreviation are next to each other, and can be found by binary
+ *  search.
+ */
+static struct mpx_command *command_table = NULL;
+
+/*! @brief	Number of commands in command_table. */
+static int num_commands = 0;
+
+/*! @brief	Number of entries allocated for command_table. */
+static int max_commands = 0;
+
+
+/*! @brief	Finds the first command whose name does not sort before \c name.
+ *
+ *  Only the first \c len characters of each command name are considered, so
+ *  with \c len equal to the length of \c name this finds the first command
+ *  that \c name abbreviates, if there is one.  If \c past_matches is true,
+ *  commands that \c name abbreviates are skipped over too, which finds the
+ *  end of the run of such commands instead.
  *
+ *  @return	Returns an index between 0 and num_commands (inclusive).
+ */
+static int search_commands( char *name, size_t len, int past_matches )
+{
+	/* Bounds of the range that is still being searched. */
+	int low = 0;
+	int high = num_commands;
+	int mid;
+
+	/* Result of comparing the middle command name to the given name. */
+	int cmp;
+
+	while ( low < high ){
+		mid = low + (high - low) / 2;
+		cmp = strncmp( command_table[mid].name, name, len );
+		if ( cmp < 0 || (cmp == 0 && past_matches) ){
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+
+/*! @brief	Adds a command to the table, which runs when given at least
+ *		\c min_len characters of its name.
  */
-static struct mpx_command *list_head = NULL;
+static void insert_command(
+	char *name,
+	void (*function)(int argc, char *argv[]),
+	size_t min_len
+)
+{
+	/* Where the new command belongs in the (sorted) table. */
+	int position;
+
+	/* Replacement table, if the current one is full. */
+	struct mpx_command *new_table;
+
+	/* Make sure there is room in the table, doubling it if needed. */
+	if ( num_commands == max_commands ){
+		new_table = (struct mpx_command *)sys_alloc_mem_nz(
+			sizeof(struct mpx_command) * (max_commands ? 2*max_commands : 16) );
+		if ( new_table == NULL ){
+			/* No room for the new command. */
+			return;
+		}
+		if ( command_table != NULL ){
+			memcpy( new_table, command_table,
+				sizeof(struct mpx_command) * num_commands );
+			sys_free_mem( command_table );
+		}
+		command_table = new_table;
+		max_commands = max_commands ? 2*max_commands : 16;
+	}
+
+	/* Find where the new command goes, and open up a gap there. */
+	position = search_commands( name, MAX_ARG_LEN+1, 0 );
+	memmove( &command_table[position+1], &command_table[position],
+		sizeof(struct mpx_command) * (num_commands - position) );
+
+	/* Initialize the new entry. */
+	command_table[position].name = (char *)sys_alloc_mem_nz(MAX_ARG_LEN+1);
+		/*! @bug	This function doesn't check for failure to
+ 		 *		allocate memory for the command name. */
+	strcpy( command_table[position].name, name );
+	command_table[position].function = function;
+	command_table[position].min_len = min_len;
+	num_commands++;
+}
 
 
 /*! @brief	Adds a command to the MPX shell.
  *
+ *  Any abbreviation of its name will run it, unless the abbreviation is
+ *  ambiguous.
  */
 void add_command(
 	/*! [in] The command name that will be made available in the shell. */
@@ -34,31 +137,53 @@ void add_command(
 	void (*function)(int argc, char *argv[])
 )
 {
-	/* Temporary variable for iterating through the list of commands. */
-	struct mpx_command *this_command;
+	insert_command( name, function, 1 );
+}
 
-	/* Allocate space for the new command structure. */
-	struct mpx_command *new_command =
-		(struct mpx_command *)sys_alloc_mem(sizeof(struct mpx_command));
-	new_command->name = (char *)sys_alloc_mem(MAX_ARG_LEN+1);
-		/*! @bug	This function doesn't check for failure to
- 		 *		allocate memory for the new command struct. */
 
-	/* Initialize the structure. */
-	strcpy( new_command->name, name );
-	new_command->function = function;
-	new_command->next = NULL;
+/*! @brief	Adds a command to the MPX shell, without taking any
+ *		abbreviations from the commands already in it.
+ *
+ *  The command can only be abbreviated to more characters than its name has
+ *  in common with any command already added; so an abbreviation that ran an
+ *  existing command goes on running it, and one that was ambiguous stays
+ *  that way.  The name it has most in common with is one of its neighbours
+ *  in the sorted table.
+ */
+void add_late_command(
+	/*! [in] The command name that will be made available in the shell. */
+	char *name,
+	/*! [in] The C function which will implement the shell command. */
+	void (*function)(int argc, char *argv[])
+)
+{
+	/* Where the command goes in the table, and the neighbour being
+	 * compared with. */
+	int position = search_commands( name, MAX_ARG_LEN+1, 0 );
+	int i;
+
+	/* Characters the name has in common with the neighbour. */
+	size_t common;
+	size_t min_len = 1;
 
-	/* Insert the new command into the linked-list of commands. */
-	this_command = list_head;
-	if ( this_command == NULL ) {
-		list_head = new_command;
-	} else {
-		while ( this_command->next != NULL ){
-			this_command = this_command->next;
+	for ( i = position - 1; i <= position; i++ ){
+		if ( i < 0 || i >= num_commands ){
+			continue;
+		}
+		common = 0;
+		while ( name[common] != '\0' &&
+			name[common] == command_table[i].name[common] ){
+			common++;
+		}
+		if ( common + 1 > min_len ){
+			min_len = common + 1;
 		}
-		this_command->next = new_command;
 	}
+	if ( min_len > strlen(name) ){
+		min_len = strlen(name);
+	}
+
+	insert_command( name, function, min_len );
 }
 
 /*! @brief	Runs the shell command specified by the user, if it is valid.
@@ -69,78 +194,73 @@ void add_command(
  *
  *  This dispatcher allows abbreviated commands; if the requested command
  *  matches multiple (or zero) valid MPX shell commands, the user is alerted.
+ *  The commands it could abbreviate are found by two binary searches of the
+ *  command table, so this does not slow down as more commands are added;
+ *  of those, it only matches the ones it is long enough to run (see
+ *  add_late_command()).
  *
- *  @attention	Produces output (via printf)!
+ *  @attention	Produces output (via mpx_printf)!
  */
 void dispatch_command( char *name, int argc, char *argv[] )
 {
+	/* Length of the (possibly abbreviated) command name given. */
+	size_t len = strlen(name);
 
-	/* Temporary variable for iterating through the list of commands. */
-	struct mpx_command *this_command = list_head;
-
-	/* Temporary variables to keep track of matching command names. */
-	int num_matches = 0;
-	struct mpx_command *first_match;
-
-	/* Iterate through the linked list of commands, */
-	while( this_command != NULL ) {
-
-		/* Check to see if the given command is a valid abbrev. for the
-		 * current command from the list: */
-		if( strncmp( this_command->name, name, strlen(name) ) == 0 ) {
-			/* If so, keep track of how many matches thus far, */
-			num_matches++;
-			if (num_matches == 1) {
-				/* This is the first match in the list for
-				 * the given command. */
-				first_match = this_command;
-			} else if (num_matches == 2) {
-				/* This is the first duplicate match; print
-				 * out the 'ambiguous command' header, plus
-				 * the first AND current ambiguous commands. */
-				printf("Ambiguous command: %s\n", name);
-				printf("    Matches:\n");
-				printf("        %s\n", first_match->name);
-				printf("        %s\n", this_command->name);
-			} else {
-				/* This is a subsequent duplicate match;
-				 * by this time, the header etc. has already
-				 * been printed, so we only need to print out
-				 * the current command name. */
-				printf("        %s\n", this_command->name);
-			}
-		}
+	/* The run of commands that the given name abbreviates: from first_match
+	 * up to, but not including, end_match. */
+	int first_match = search_commands( name, len, 0 );
+	int end_match = search_commands( name, len, 1 );
+
+	/* Number of those it is long enough to run, and the last of them. */
+	int matches = 0;
+	int match = 0;
 
-		this_command = this_command->next;
+	/* Loop index. */
+	int i;
+
+	for ( i = first_match; i < end_match; i++ ){
+		if ( len >= command_table[i].min_len ){
+			matches++;
+			match = i;
+		}
 	}
 
 	/* If we got a command name that matches unambiguously, run that cmd: */
-	if ( num_matches == 1 ){
-		first_match->function(argc, argv);
+	if ( matches == 1 ){
+		command_table[match].function(argc, argv);
 	}
-	
+
 	/* Otherwise, if we got no matches at all, say so: */
-	if ( num_matches == 0 ){
-		printf("ERROR: Invalid command name.\n");
-		printf("Type \"help\" to see a list of valid commands.\n");
+	else if ( matches == 0 ){
+		mpx_printf("ERROR: Invalid command name.\n");
+		mpx_printf("Type \"help\" to see a list of valid commands.\n");
+	}
+
+	/* Otherwise, the command is ambiguous; list the candidates: */
+	else {
+		mpx_printf("Ambiguous command: %s\n", name);
+		mpx_printf("    Matches:\n");
+		for ( i = first_match; i < end_match; i++ ){
+			if ( len >= command_table[i].min_len ){
+				mpx_printf("        %s\n", command_table[i].name);
+			}
+		}
 	}
 }
 
 void mpxcmd_commands( int argc, char *argv[] )
 {
 
-	/* Temporary variable for iterating through the list of commands. */
-	struct mpx_command *this_command = list_head;
-
-	printf("\n");
-	printf("    The following commands are available to you:\n");
-	printf("\n");
+	/* Loop index. */
+	int i;
 
-	while( this_command != NULL ) {
+	mpx_printf("\n");
+	mpx_printf("    The following commands are available to you:\n");
+	mpx_printf("\n");
 
-		printf("        %s\n", this_command->name);
+	for ( i = 0; i < num_commands; i++ ){
 
-		this_command = this_command->next;
+		mpx_printf("        %s\n", command_table[i].name);
 	}
 }
 
@@ -156,7 +276,7 @@ void mpxcmd_date( int argc, char *argv[] )
 	/* Called with no arguments, we should just print the date: */
 	if ( argc == 1 ){
 		sys_get_date(&date);
-		printf("Current MPX system date (yyyy-mm-dd): %04d-%02d-%02d\n",
+		mpx_printf("Current MPX system date (yyyy-mm-dd): %04d-%02d-%02d\n",
 				date.year, date.month, date.day);
 		return;
 	}
@@ -173,28 +293,28 @@ void mpxcmd_date( int argc, char *argv[] )
 		/* Check that the user's input represents a valid date: */
 		if ( ! mpx_validate_date(date.year, date.month, date.day) ) {
 			/* Lines broken confusingly due to 80-column limit: */
-			printf("ERROR: Invalid date specified; ");
-			printf("MPX system date is unchanged.\n");
-			printf("       Valid dates are between 1900-01-01 ");
-			printf("and 2999-12-31, inclusive.\n");
+			mpx_printf("ERROR: Invalid date specified; ");
+			mpx_printf("MPX system date is unchanged.\n");
+			mpx_printf("       Valid dates are between 1900-01-01 ");
+			mpx_printf("and 2999-12-31, inclusive.\n");
 			return;
 		}
 
 		/* Attempt to set that date, catching errors: */
 		retval = sys_set_date(&date);
 		if ( retval != 0 ) {
-			printf("ERROR: sys_set_date() returned an error.\n");
+			mpx_printf("ERROR: sys_set_date() returned an error.\n");
 			return;
 		}
 
 		/* Success! */
-		printf("The MPX system date has been changed.\n");
+		mpx_printf("The MPX system date has been changed.\n");
 		return;
 	}
 
 	/* If we get to here, the user invoked the date command incorrectly. */
-	printf("ERROR: Wrong number of arguments to 'date'.\n");
-	printf("       Type 'help date' for usage information.\n");
+	mpx_printf("ERROR: Wrong number of arguments to 'date'.\n");
+	mpx_printf("       Type 'help date' for usage information.\n");
 }
 
 
@@ -204,12 +324,19 @@ void mpxcmd_exit( int argc, char *argv[] )
 	int buf_size=20;
 	int retval;
 
-	printf("  ** Are you sure you want to terminate MPX? [y/n] ");
+	/* A script has nobody to ask; just go. */
+	if ( mpx_batch_mode() ) {
+		mpx_flush();
+		sys_exit();
+	}
+
+	mpx_printf("  ** Are you sure you want to terminate MPX? [y/n] ");
+	mpx_flush();
 
 	retval = sys_req( READ, TERMINAL, buf, &buf_size );
 	if ( retval < 0 ) {
-		printf("ERROR: sys_req() threw error while trying to read ");
-		printf("from the terminal!\n");
+		mpx_printf("ERROR: sys_req() threw error while trying to read ");
+		mpx_printf("from the terminal!\n");
 		return;
 	}
 
@@ -240,13 +367,13 @@ void mpxcmd_help( int argc, char *argv[] )
 
 	if ( argc == 1 ) {
 		mpxcmd_commands(argc, argv);
-		printf("\n");
-		printf("    For detailed help a specific command, type:\n");
-		printf("\n");
-		printf("            help <command>\n");
-		printf("            --------------\n");
-		printf("\n");
-		printf("   at the MPX shell prompt.\n");
+		mpx_printf("\n");
+		mpx_printf("    For detailed help a specific command, type:\n");
+		mpx_printf("\n");
+		mpx_printf("            help <command>\n");
+		mpx_printf("            --------------\n");
+		mpx_printf("\n");
+		mpx_printf("   at the MPX shell prompt.\n");
 		return;
 	}
 
@@ -255,21 +382,21 @@ void mpxcmd_help( int argc, char *argv[] )
 		strncat(helpfile, argv[1], MAX_ARG_LEN);
 		strncat(helpfile, ".hlp", 4);
 
-		printf("\n");
+		mpx_printf("\n");
 		if ( ! mpx_cat(helpfile) ){
-			printf("No help available for command '%s'\n", argv[1]);
+			mpx_printf("No help available for command '%s'\n", argv[1]);
 		}
 		return;
 	}
 
-	printf("ERROR: Wrong number of arguments to 'help'.\n");
-	printf("       Type 'help help' for usage information.\n");
+	mpx_printf("ERROR: Wrong number of arguments to 'help'.\n");
+	mpx_printf("       Type 'help help' for usage information.\n");
 }
 
 
 void mpxcmd_version( int argc, char *argv[] )
 {
-	printf("MPX System Version: %s\n", MPX_VERSION);
+	mpx_printf("MPX System Version: %s\n", MPX_VERSION);
 }
 
 
@@ -288,49 +415,74 @@ void mpxcmd_ls( int argc, char *argv[] )
 		dir = argv[1];
 	}
 	else {
-		printf("ERROR: Wrong number of arguments to 'ls'.\n");
-		printf("       Type 'help ls' for usage information.\n");
+		mpx_printf("ERROR: Wrong number of arguments to 'ls'.\n");
+		mpx_printf("       Type 'help ls' for usage information.\n");
 		return;
 	}
 
 	retval = sys_open_dir( dir );
 	if ( retval != 0 ){
-		printf("ERROR: sys_open_dir() failed");
-		printf("trying to open directory '%s'.\n", dir);
+		mpx_printf("ERROR: sys_open_dir() failed");
+		mpx_printf("trying to open directory '%s'.\n", dir);
 		return;
 	}
 
-	printf("\n");
-	printf("    Listing of files in directory '%s':\n", dir);
-	printf("\n");
-	printf("File Name:         File Size (in bytes):\n");
-	printf("---------------    ------------------------------\n");
+	mpx_printf("\n");
+	mpx_printf("    Listing of files in directory '%s':\n", dir);
+	mpx_printf("\n");
+	mpx_printf("File Name:         File Size (in bytes):\n");
+	mpx_printf("---------------    ------------------------------\n");
 
 	num_files = 0;
 	for(;;){
 		retval = sys_get_entry(file_name, MAX_FILENAME_LEN, &file_size);
 		if ( retval == 0 ) {
-			printf("%-15s    %30ld\n", file_name, file_size);
+			mpx_printf("%-15s    %30ld\n", file_name, file_size);
 			num_files++;
 		}
 		else if ( retval == ERR_SUP_NOENTR ) {
 			break;
 		}
 		else {
-			printf("ERROR: sys_get_entry() failed");
-			printf("trying to read directory '%s'.\n", dir);
-			printf("Giving up on this directory.\n");
+			mpx_printf("ERROR: sys_get_entry() failed");
+			mpx_printf("trying to read directory '%s'.\n", dir);
+			mpx_printf("Giving up on this directory.\n");
 			return;
 		}
 	}
 
-	printf("\n");
-	printf("Total files in directory: %d\n", num_files);
+	mpx_printf("\n");
+	mpx_printf("Total files in directory: %d\n", num_files);
 
 	retval = sys_close_dir();
 	if ( retval != 0 ){
-		printf("ERROR: sys_close_dir() returned an error.\n");
+		mpx_printf("ERROR: sys_close_dir() returned an error.\n");
+	}
+}
+
+
+/*! Finds the process that a shell argument names.
+ *
+ * The argument is either a process name, or '#' followed by a process
+ * handle (as shown by <tt>ps</tt>).
+ *
+ * @return	Returns a pointer to the PCB, or NULL if there is no such
+ *		process.
+ */
+static pcb_t* lookup_process( char *arg )
+{
+	char		*end;
+	pcb_handle_t	 handle;
+
+	if ( arg[0] == '#' ){
+		handle = strtoul( arg+1, &end, 10 );
+		if ( end == arg+1 || *end != '\0' ){
+			return NULL;
+		}
+		return get_pcb( handle );
 	}
+
+	return find_pcb( arg );
 }
 
 
@@ -341,34 +493,34 @@ void mpxcmd_suspend ( int argc, char *argv[] )
 	pcb_t		*pcb;
 
 	if ( argc != 2 ){
-		printf("ERROR: Wrong number of arguments to suspend.\n");
+		mpx_printf("ERROR: Wrong number of arguments to suspend.\n");
 		return;
 	}
 
 	if ( strlen(argv[1]) > MAX_ARG_LEN || strlen(argv[1]) < 1 ){
-		printf("ERROR: Invalid process name.\n");
+		mpx_printf("ERROR: Invalid process name.\n");
 		return;
 	}
 
-	pcb = find_pcb( argv[1] );
+	pcb = lookup_process( argv[1] );
 	if ( pcb == NULL ){
-		printf("ERROR: Specified process does not exist.\n");
+		mpx_printf("ERROR: Specified process does not exist.\n");
 		return;
 	}
 
 	if ( is_suspended(pcb) ){
-		printf("ERROR: Specified process is already suspended.\n");
+		mpx_printf("ERROR: Specified process is already suspended.\n");
 		return;
 	}
 
 	/* Suspend PCB, checking for error return. */
 	if ( ! suspend_pcb(pcb) ){
-		printf("ERROR: Unspecified error suspending process.");
+		mpx_printf("ERROR: Unspecified error suspending process.");
 		return;
 	}
 
 	/* Let the user know that the operation was successful. */
-	printf("Success: Process '%s' is now suspended.\n", argv[1]);
+	mpx_printf("Success: Process '%s' is now suspended.\n", argv[1]);
 }
 
 
@@ -380,58 +532,67 @@ void mpxcmd_resume ( int argc, char *argv[] )
 	pcb_t		*pcb;
 
 	if ( argc != 2 ){
-		printf("ERROR: Wrong number of arguments to resume.\n");
+		mpx_printf("ERROR: Wrong number of arguments to resume.\n");
 		return;
 	}
 
 	if ( strlen(argv[1]) > MAX_ARG_LEN || strlen(argv[1]) < 1 ){
-		printf("ERROR: Invalid process name.\n");
+		mpx_printf("ERROR: Invalid process name.\n");
 		return;
 	}
 
-	pcb = find_pcb( argv[1] );
+	pcb = lookup_process( argv[1] );
 	if ( pcb == NULL ){
-		printf("ERROR: Specified process does not exist.\n");
+		mpx_printf("ERROR: Specified process does not exist.\n");
 		return;
 	}
 
 	if ( ! is_suspended(pcb) ){
-		printf("ERROR: Specified process is not suspended.\n");
+		mpx_printf("ERROR: Specified process is not suspended.\n");
 		return;
 	}
 
 	/* Un-suspend PCB, checking for error return. */
 	if ( ! resume_pcb(pcb) ){
-		printf("ERROR: Unspecified error resuming process.");
+		mpx_printf("ERROR: Unspecified error resuming process.");
 		return;
 	}
 
 	/* Let the user know that the operation was successful. */
-	printf("Success: Process '%s' is no longer suspended.\n", argv[1]);
-}
-
-
-/*! Implements the <tt>renice</tt> shell command.
- *
- */
-void mpxcmd_renice ( int argc, char *argv[] )
-{
+	mpx_printf("Success: Process '%s' is no longer suspended.\n", argv[1]);
 }
 
 
 void print_pcb_info( pcb_t *pcb ){
 	char *process_state = process_state_to_string(pcb->state);
 	char *process_class = process_class_to_string(pcb->class);
+	unsigned long estimate;
 	
-	printf("\n");
-	printf("+-PROCESS----- Name: %-24s",  pcb->name);
-		printf(" --------------------\n");
-	printf("|             Class: %s\n",   process_class);
-	printf("|          Priority: %-4d\n", pcb->priority);
-	printf("|             State: %s\n",   process_state);
-	printf("|       Memory Size: %-8d\n", pcb->memory_size);
-	printf("|        Stack Size: %-8d\n", pcb->stack_top - pcb->stack_base);
-	printf("+----------------------------------------------------------\n");
+	mpx_printf("\n");
+	mpx_printf("+-PROCESS----- Name: %-24s",  get_pcb_name(pcb));
+		mpx_printf(" --------------------\n");
+	mpx_printf("|            Handle: #%lu\n", get_pcb_handle(pcb));
+	mpx_printf("|             Class: %s\n",   process_class);
+	mpx_printf("|          Priority: %-4d\n", pcb->priority);
+	mpx_printf("|             Group: %s\n",
+		get_group(pcb->group)->name);
+	mpx_printf("|             State: %s\n",   process_state);
+	mpx_printf("|       Memory Size: %-8d\n", pcb->cold->memory_size);
+	mpx_printf("|        Stack Size: %-8d\n",
+		pcb->cold->stack_top - pcb->cold->stack_base);
+	if ( pcb->class == REALTIME ){
+		mpx_printf("|            Period: %u ticks\n", pcb->sched->rt_period);
+		mpx_printf("|            Budget: %u ticks\n", pcb->sched->rt_budget);
+		mpx_printf("|          Deadline: %u ticks\n",
+			pcb->sched->rt_deadline);
+		mpx_printf("|     Jobs (Missed): %lu (%lu)\n",
+			pcb->sched->rt_jobs, pcb->sched->rt_misses);
+	} else if ( get_sched_policy() == &sched_sjf ){
+		estimate = get_burst_estimate(pcb);
+		mpx_printf("|    Burst Estimate: %lu.%lu ticks\n",
+			estimate / 10, estimate % 10);
+	}
+	mpx_printf("+----------------------------------------------------------\n");
 }
 
 
@@ -439,326 +600,1709 @@ void print_pcb_info_oneline( pcb_t *pcb ){
 	char *process_state = process_state_to_string(pcb->state);
 	char process_class = process_class_to_char(pcb->class);
 
-	printf("%-24s    %c    %4d  %8d  %8d  ",
-		pcb->name,
+	mpx_printf("    %-24s    %c    %4d  %8d  %10lu  %s\n",
+		get_pcb_name(pcb),
 		process_class,
 		pcb->priority,
-		pcb->memory_size,
-		(pcb->stack_top - pcb->stack_base)
+		pcb->cold->memory_size,
+		get_pcb_handle(pcb),
+		process_state
 	);
-	printf("%s\n", process_state);
 }
 
 
-/*! Implements the <tt>ps</tt> shell command.
- *
- */
-void mpxcmd_ps ( int argc, char *argv[] )
-{
-	int i;
-	pcb_t *specified_pcb;
-	pcb_queue_node_t *iter_node;
+/*! Output formats for the <tt>ps</tt> shell command (see <tt>ps -o</tt>). */
+typedef enum {
 
-	int print_ready		= 0;
-	int print_suspended	= 0;
-	int print_blocked	= 0;
-	int print_in_reverse	= 0;
+	PS_FORMAT_TEXT,
+	PS_FORMAT_CSV,
+	PS_FORMAT_JSON,
+	PS_FORMAT_BIN
 
-	if ( argc == 3 && strcmp("--", argv[2]) == 0 ){
-		specified_pcb = find_pcb( argv[1] );
-		if (specified_pcb == NULL ){
-			printf("ERROR: Specified process does not exist.\n");
-			return;
-		}
-		print_pcb_info( specified_pcb );
-		return;
-	}
+} ps_format_t;
 
-	if ( argc == 2 && argv[1][0] != '-' ){
-		specified_pcb = find_pcb( argv[1] );
-		if (specified_pcb == NULL ){
-			printf("ERROR: Specified process does not exist.\n");
-			return;
-		}
-		print_pcb_info( specified_pcb );
-		return;
-	}
+/*! Size (in bytes) of each record in <tt>ps -o bin</tt> output. */
+#define PS_BIN_RECORD_SIZE	(MAX_ARG_LEN+1 + 1 + 2 + 1 + 4 + 4 + 4)
 
-	for ( i = 1; i < argc; i++ ) {
-		if ( strcmp("-r", argv[i]) == 0 ){
-			print_ready = 1;
-		} else
-		if (strcmp( "-s", argv[i]) == 0 ){
-			print_suspended = 1;
-		} else
-		if (strcmp( "-b", argv[i]) == 0 ){
-			print_blocked = 1;
-		} else
-		if (strcmp( "-a", argv[i]) == 0 ){
-			print_ready = 1;
-			print_suspended = 1;
-			print_blocked = 1;
-		} else
-		if (strcmp( "-R", argv[i]) == 0 ){
-			print_in_reverse = 1;
-		}
-		else {
-			printf("ERROR: Invalid argument '%s'.", argv[i]);
-			printf("Remember, flags are case-sensitive.\n");
-			return;
-		}
-	}
+/*! Version number in the header of <tt>ps -o bin</tt> output. */
+#define PS_BIN_VERSION		2
 
-	if ( argc == 1 || (argc == 2 && print_in_reverse) ) {
-		print_ready = 1;
-		print_suspended = 1;
-		print_blocked = 1;
-	}
+/*! Size (in bytes) of the header of <tt>ps -o bin</tt> output. */
+#define PS_BIN_HEADER_SIZE	10
 
-	printf("\n");
-	printf(" ===");
-	printf(" =======================  =====  ====  ========  ========");
-	printf("  ================\n");
-	printf("    ");
-	printf(" Process Name             Class  Prio  Mem Size  Stk Size");
-	printf("  State\n");
-	printf(" ===");
-	printf(" =======================  =====  ====  ========  ========");
-	printf("  ================\n");
 
-	if ( print_ready ){
-		printf("\n");
-		printf("  Processes in state READY:\n");
-		printf("  -------------------------\n");
-		foreach_listitem_rev(
-			iter_node,
-			get_queue_by_state(READY),
-			print_in_reverse
-		){
-			printf("    ");
-			print_pcb_info_oneline( iter_node->pcb );
-		}
+/*! Stores the low \c size bytes of \c value at \c dest, least significant
+ *  byte first, so that binary output is the same on any host. */
+static void put_le( unsigned char *dest, unsigned long value, int size )
+{
+	while ( size-- > 0 ){
+		*dest++ = (unsigned char)(value & 0xFF);
+		value >>= 8;
 	}
+}
+
 
-	if ( print_blocked ){
-		printf("\n");
-		printf("  Processes in state BLOCKED:\n");
-		printf("  ---------------------------\n");
-		foreach_listitem_rev(
-			iter_node,
-			get_queue_by_state(BLOCKED),
-			print_in_reverse
-		){
-			printf("    ");
-			print_pcb_info_oneline( iter_node->pcb );
+/*! Copies a process name to \c dest, quoted for the given format.
+ *
+ *  CSV names are only quoted if they contain a comma or a double quote;
+ *  JSON names are always quoted, with backslash escapes as needed.
+ *  \c dest must hold at least 6*MAX_ARG_LEN+3 bytes.
+ */
+static void quote_name( char *dest, char *name, ps_format_t format )
+{
+	if ( format == PS_FORMAT_CSV ){
+		if ( strpbrk( name, ",\"" ) == NULL ){
+			strcpy( dest, name );
+			return;
 		}
-	}
-		
-	if ( print_ready || print_suspended ){
-		printf("\n");
-		printf("  Processes in state SUSP_READY:\n");
-		printf("  ------------------------------\n");
-		foreach_listitem_rev(
-			iter_node,
-			get_queue_by_state(SUSP_READY),
-			print_in_reverse
-		){
-			printf("    ");
-			print_pcb_info_oneline( iter_node->pcb );
+		*dest++ = '"';
+		for ( ; *name != '\0'; name++ ){
+			if ( *name == '"' ){
+				*dest++ = '"';
+			}
+			*dest++ = *name;
 		}
-	}
-
-	if ( print_blocked || print_suspended ){
-		printf("\n");
-		printf("  Processes in state SUSP_BLOCKED:\n");
-		printf("  --------------------------------\n");
-		foreach_listitem_rev(
-			iter_node,
-			get_queue_by_state(SUSP_BLOCKED),
-			print_in_reverse
-		){
-			printf("    ");
-			print_pcb_info_oneline( iter_node->pcb );
+	} else {
+		*dest++ = '"';
+		for ( ; *name != '\0'; name++ ){
+			if ( *name == '"' || *name == '\\' ){
+				*dest++ = '\\';
+				*dest++ = *name;
+			} else if ( (unsigned char)*name < 0x20 ){
+				sprintf( dest, "\\u%04x", (unsigned char)*name );
+				dest += 6;
+			} else {
+				*dest++ = *name;
+			}
 		}
 	}
+	*dest++ = '"';
+	*dest = '\0';
 }
 
 
-/*! Implements the <tt>create_pcb</tt> shell command.
- *
- * \attention This TEMPORARY command will be replaced later. */
-void mpxcmd_create_pcb ( int argc, char *argv[] )
+/*! Prints one PCB as a CSV row, a JSON object, or a binary record.
+ */
+static void print_pcb_record( pcb_t *pcb, ps_format_t format )
 {
-	pcb_t		*new_pcb;
-	int		 new_pcb_priority;
-	process_class_t	 new_pcb_class;
-	pcb_queue_t	*new_pcb_dest_queue;
-
-	if ( argc != 4 ){
-		printf("ERROR: Wrong number of arguments to create_pcb.\n");
+	char		name[6*MAX_ARG_LEN+3];
+	unsigned char	record[PS_BIN_RECORD_SIZE];
+
+	if ( format == PS_FORMAT_BIN ){
+		memset( record, 0, sizeof(record) );
+		strncpy( (char *)record, get_pcb_name(pcb), MAX_ARG_LEN );
+		record[MAX_ARG_LEN+1] = (unsigned char)pcb->class;
+		put_le( &record[MAX_ARG_LEN+2], (unsigned long)pcb->priority, 2 );
+		record[MAX_ARG_LEN+4] = (unsigned char)pcb->state;
+		put_le( &record[MAX_ARG_LEN+5],
+			(unsigned long)pcb->cold->memory_size, 4 );
+		put_le( &record[MAX_ARG_LEN+9],
+			(unsigned long)(pcb->cold->stack_top -
+				pcb->cold->stack_base), 4 );
+		put_le( &record[MAX_ARG_LEN+13], get_pcb_handle(pcb), 4 );
+		mpx_write( (char *)record, PS_BIN_RECORD_SIZE );
 		return;
 	}
 
-	if ( strlen(argv[1]) > MAX_ARG_LEN ) {
-		printf("ERROR: Specified process name is too long.\n");
-		return;
+	quote_name( name, get_pcb_name(pcb), format );
+
+	if ( format == PS_FORMAT_CSV ){
+		mpx_printf("%s,%s,%d,%s,%d,%d,%lu\n",
+			name,
+			process_class_to_string(pcb->class),
+			pcb->priority,
+			process_state_to_string(pcb->state),
+			pcb->cold->memory_size,
+			(pcb->cold->stack_top - pcb->cold->stack_base),
+			get_pcb_handle(pcb)
+		);
+	} else {
+		mpx_printf("{\"name\":%s,\"class\":\"%s\",\"priority\":%d,"
+			"\"state\":\"%s\",\"memory_size\":%d,"
+			"\"stack_size\":%d,\"handle\":%lu}\n",
+			name,
+			process_class_to_string(pcb->class),
+			pcb->priority,
+			process_state_to_string(pcb->state),
+			pcb->cold->memory_size,
+			(pcb->cold->stack_top - pcb->cold->stack_base),
+			get_pcb_handle(pcb)
+		);
 	}
+}
 
-	new_pcb_priority = atoi(argv[3]);
 
-	if ( new_pcb_priority < -127 || new_pcb_priority > 128 ){
-		printf("ERROR: Invalid priority specified.\n");
-		printf("Priority must be between -127 and 128 (inclusive).\n");
-		return;
-	}
-	
-	if ( strlen(argv[2]) == 1 &&
-				(argv[2][0] == 'A' || argv[2][0] == 'a') ){
-		new_pcb_class = APPLICATION;
-	} else if ( strlen(argv[2]) == 1 &&
-				(argv[2][0] == 'S' || argv[2][0] == 's') ){
-		new_pcb_class = SYSTEM;
-	} else {
-		printf("ERROR: Invalid process class specified.\n");
-		return;
-	}
-	
-	new_pcb = setup_pcb( argv[1], new_pcb_priority, new_pcb_class);
+/*! Sort keys for the <tt>ps</tt> shell command (see <tt>ps -k</tt>). */
+typedef enum {
 
-	if ( new_pcb == NULL ){
-		printf("ERROR: Failure creating process.\n");
-		return;
-	}
+	PS_KEY_QUEUE,
+	PS_KEY_PRIO,
+	PS_KEY_NAME,
+	PS_KEY_MEM
 
-	new_pcb_dest_queue = insert_pcb( new_pcb );
+} ps_key_t;
 
-	if ( new_pcb_dest_queue == NULL ){
-		printf("ERROR: Failure enqueuing new process.\n");
-	}
 
-	printf("Success: Process created.\n");
-}
+/*! Which processes the <tt>ps</tt> shell command should list. */
+typedef struct ps_filter {
 
+	/*! Only list processes of this class; -1 to list any class. */
+	int		class;
 
-/*! Implements the <tt>delete_pcb</tt> shell command.
- *
- * \attention This TEMPORARY command will be replaced later. */
-void mpxcmd_delete_pcb ( int argc, char *argv[] )
-{
-	pcb_t		*pcb;
-	pcb_queue_t	*retval;
+	/*! Only list processes with priorities from prio_lo through prio_hi
+	 *  (inclusive). */
+	int		prio_lo;
+	int		prio_hi;
 
-	if ( argc != 2 ){
-		printf("ERROR: Wrong number of arguments to create_pcb.\n");
-		return;
-	}
+	/*! Only list processes whose names start with this string; NULL to
+	 *  list any name. */
+	char		*prefix;
 
-	if ( strlen(argv[1]) > MAX_ARG_LEN || strlen(argv[1]) < 1 ){
-		printf("ERROR: Invalid process name.\n");
-		return;
-	}
-	
-	pcb = find_pcb( argv[1] );
-	if ( pcb == NULL ){
-		printf("ERROR: Specified process does not exist.\n");
-		return;
-	}
+	/*! Length of prefix. */
+	size_t		prefix_len;
 
-	retval = remove_pcb( pcb );
-	if ( retval == NULL ){
-		printf("ERROR: Unspecified error removing PCB.\n");
-		return;
-	}
+	/*! Only list processes in this group; -1 to list any group. */
+	int		group;
 
-	free_pcb( pcb );
+} ps_filter_t;
 
-	printf("Success: PCB for process '%s' removed.\n", argv[1]);
+
+/*! Sets a filter to let every process through. */
+static void ps_init_filter( ps_filter_t *filter )
+{
+	filter->class = -1;
+	filter->prio_lo = PRIORITY_MIN;
+	filter->prio_hi = PRIORITY_MAX;
+	filter->prefix = NULL;
+	filter->prefix_len = 0;
+	filter->group = -1;
 }
 
 
-/*! Implements the <tt>block</tt> shell command.
+/*! Parses argv[*i] if it is a filter flag (-c, -p, -n, or -g), along with
+ *  its argument, leaving *i at the last argument used.
  *
- * \attention This TEMPORARY command will be replaced later. */
-void mpxcmd_block ( int argc, char *argv[] )
+ *  @return	Returns 1 if a flag was parsed, 0 if argv[*i] is not a filter
+ *		flag, or -1 if it is but its argument is invalid (the error
+ *		has been reported).
+ */
+static int ps_parse_filter(
+	int		 argc,
+	char		*argv[],
+	int		*i,
+	ps_filter_t	*filter
+)
 {
-	pcb_t		*pcb;
-
-	if ( argc != 2 ){
-		printf("ERROR: Wrong number of arguments to block.\n");
-		return;
+	char	*flag = argv[*i];
+	char	*arg;
+	char	*colon;
+
+	if ( *i+1 >= argc ||
+	     ( strcmp( "-c", flag ) != 0 && strcmp( "-p", flag ) != 0 &&
+	       strcmp( "-n", flag ) != 0 && strcmp( "-g", flag ) != 0 ) ){
+		return 0;
 	}
-
-	if ( strlen(argv[1]) > MAX_ARG_LEN || strlen(argv[1]) < 1 ){
-		printf("ERROR: Invalid process name.\n");
-		return;
+	arg = argv[++*i];
+
+	if ( strcmp( "-c", flag ) == 0 ){
+		if ( strcmp( "A", arg ) == 0 || strcmp( "a", arg ) == 0 ){
+			filter->class = APPLICATION;
+		} else if ( strcmp( "S", arg ) == 0 || strcmp( "s", arg ) == 0 ){
+			filter->class = SYSTEM;
+		} else if ( strcmp( "R", arg ) == 0 || strcmp( "r", arg ) == 0 ){
+			filter->class = REALTIME;
+		} else {
+			mpx_printf("ERROR: Invalid process class specified.\n");
+			return -1;
+		}
 	}
 
-	pcb = find_pcb( argv[1] );
-	if ( pcb == NULL ){
-		printf("ERROR: Specified process does not exist.\n");
-		return;
+	if ( strcmp( "-p", flag ) == 0 ){
+		colon = strchr( arg, ':' );
+		if ( colon == NULL ){
+			filter->prio_lo = filter->prio_hi = atoi( arg );
+		} else {
+			filter->prio_lo = colon == arg ?
+				PRIORITY_MIN : atoi( arg );
+			filter->prio_hi = colon[1] == '\0' ?
+				PRIORITY_MAX : atoi( colon+1 );
+		}
+		if ( filter->prio_lo < PRIORITY_MIN ||
+		     filter->prio_hi > PRIORITY_MAX ||
+		     filter->prio_lo > filter->prio_hi ){
+			mpx_printf("ERROR: Invalid priority range '%s'.\n", arg);
+			mpx_printf("Priority must be between -127 and 128 (inclusive).\n");
+			return -1;
+		}
 	}
 
-	if ( is_blocked(pcb) ){
-		printf("ERROR: Specified process is already blocked.\n");
-		return;
+	if ( strcmp( "-n", flag ) == 0 ){
+		filter->prefix = arg;
+		filter->prefix_len = strlen( arg );
 	}
 
-	/* Block PCB, checking for error return. */
-	if ( ! block_pcb(pcb) ){
-		printf("ERROR: Unspecified error blocking process.");
-		return;
+	if ( strcmp( "-g", flag ) == 0 ){
+		filter->group = find_group( arg );
+		if ( filter->group < 0 ){
+			mpx_printf("ERROR: Group '%s' does not exist.\n", arg);
+			return -1;
+		}
 	}
 
-	/* Let the user know that the operation was successful. */
-	printf("Success: Process '%s' is now blocked.\n", argv[1]);
+	return 1;
 }
 
 
-/*! Implements the <tt>unblock</tt> shell command.
+/*! Works out which queues the -r, -s, and -b flags select (all of them, if
+ *  none of the flags was given).
  *
- * \attention This TEMPORARY command will be replaced later. */
-void mpxcmd_unblock ( int argc, char *argv[] )
+ *  @return	Returns the number of queues selected; \c selected[] gets the
+ *		queues, terminated by NULL, and \c states[] their states.
+ */
+static int ps_select_queues(
+	int		 ready,
+	int		 suspended,
+	int		 blocked,
+	/*! [out] Room for six entries. */
+	pcb_queue_t	*selected[],
+	/*! [out] Room for five entries. */
+	process_state_t	 states[]
+)
 {
-	pcb_t		*pcb;
+	int num_selected = 0;
+	int realtime;
+	int i;
 
-	if ( argc != 2 ){
-		printf("ERROR: Wrong number of arguments to unblock.\n");
-		return;
+	if ( !ready && !suspended && !blocked ) {
+		ready = 1;
+		suspended = 1;
+		blocked = 1;
 	}
 
-	if ( strlen(argv[1]) > MAX_ARG_LEN || strlen(argv[1]) < 1 ){
-		printf("ERROR: Invalid process name.\n");
-		return;
+	/* Ready real-time processes come first, in a queue of their own
+	 * (which is left out when it is empty). */
+	realtime = ready && get_realtime_queue()->length > 0;
+	if ( realtime ){
+		selected[num_selected] = get_realtime_queue();
+		states[num_selected++] = READY;
 	}
-
-	pcb = find_pcb( argv[1] );
-	if ( pcb == NULL ){
-		printf("ERROR: Specified process does not exist.\n");
-		return;
+	if ( ready ){
+		states[num_selected++] = READY;
 	}
-
-	if ( ! is_blocked(pcb) ){
-		printf("ERROR: Specified process is not blocked.\n");
-		return;
+	if ( blocked ){
+		states[num_selected++] = BLOCKED;
 	}
-
-	/* Unblock PCB, checking for error return. */
-	if ( ! unblock_pcb(pcb) ){
-		printf("ERROR: Unspecified error unblocking process.");
-		return;
+	if ( ready || suspended ){
+		states[num_selected++] = SUSP_READY;
 	}
+	if ( blocked || suspended ){
+		states[num_selected++] = SUSP_BLOCKED;
+	}
+	for ( i = realtime ? 1 : 0; i < num_selected; i++ ){
+		selected[i] = get_queue_by_state( states[i] );
+	}
+	selected[num_selected] = NULL;
 
-	/* Let the user know that the operation was successful. */
-	printf("Success: Process '%s' is now unblocked.\n", argv[1]);
-
+	return num_selected;
 }
 
 
-void init_commands(void)
+/*! Tells whether a PCB passes the filter. */
+static int ps_matches( pcb_t *pcb, ps_filter_t *filter )
 {
-	/* R1 commands */
-	add_command("date", mpxcmd_date);
+	return pcb->priority >= filter->prio_lo &&
+	       pcb->priority <= filter->prio_hi &&
+	       ( filter->class < 0 || pcb->class == filter->class ) &&
+	       ( filter->group < 0 || pcb->group == filter->group ) &&
+	       ( filter->prefix == NULL ||
+		 strncmp( get_pcb_name(pcb), filter->prefix,
+			filter->prefix_len ) == 0 );
+}
+
+
+/*! Tells whether PCB \c a should be listed before PCB \c b, sorting by
+ *  \c key.
+ *
+ *  Priorities and memory sizes are listed largest first.  Ties are broken
+ *  by name, which is unique, so no two PCBs are ever equal.
+ */
+static int ps_before( pcb_t *a, pcb_t *b, ps_key_t key )
+{
+	if ( key == PS_KEY_PRIO && a->priority != b->priority ){
+		return a->priority > b->priority;
+	}
+	if ( key == PS_KEY_MEM &&
+	     a->cold->memory_size != b->cold->memory_size ){
+		return a->cold->memory_size > b->cold->memory_size;
+	}
+	return strcmp( get_pcb_name(a), get_pcb_name(b) ) < 0;
+}
+
+
+/*! Ends a scan of a PRIORITY queue once it leaves the filter's priority
+ *  range; see ps_scan_first(). */
+static pcb_queue_node_t* ps_scan_clip(
+	pcb_queue_t		*queue,
+	pcb_queue_node_t	*node,
+	ps_filter_t		*filter,
+	int			 reverse
+)
+{
+	if ( node == NULL || queue->sort_order != PRIORITY ){
+		return node;
+	}
+	if ( reverse ? node->pcb->priority > filter->prio_hi
+		     : node->pcb->priority < filter->prio_lo ){
+		return NULL;
+	}
+	return node;
+}
+
+
+/*! Starts a scan of a queue for PCBs that may pass the filter.
+ *
+ *  For a PRIORITY queue, the scan covers only the part of the queue within
+ *  the filter's priority range, which is found without walking the list;
+ *  a FIFO queue must be scanned from end to end.  Either way, the caller
+ *  must still check each PCB with ps_matches().
+ */
+static pcb_queue_node_t* ps_scan_first(
+	pcb_queue_t	*queue,
+	ps_filter_t	*filter,
+	int		 reverse
+)
+{
+	return ps_scan_clip( queue,
+		reverse ? last_node_at_or_above( queue, filter->prio_lo )
+			: first_node_at_or_below( queue, filter->prio_hi ),
+		filter, reverse );
+}
+
+
+/*! Continues a scan started by ps_scan_first(). */
+static pcb_queue_node_t* ps_scan_next(
+	pcb_queue_t		*queue,
+	pcb_queue_node_t	*node,
+	ps_filter_t		*filter,
+	int			 reverse
+)
+{
+	return ps_scan_clip( queue, reverse ? node->prev : node->next,
+		filter, reverse );
+}
+
+
+/*! Prints one PCB in the given format. */
+static void ps_print_pcb( pcb_t *pcb, ps_format_t format )
+{
+	if ( format == PS_FORMAT_TEXT ){
+		print_pcb_info_oneline( pcb );
+	} else {
+		print_pcb_record( pcb, format );
+	}
+}
+
+
+/*! Prints whatever comes before the first PCB in the given format.
+ *
+ *  \c count is the number of PCBs that will follow; only the binary format
+ *  needs it.
+ */
+static void ps_print_header( ps_format_t format, unsigned long count )
+{
+	unsigned char header[PS_BIN_HEADER_SIZE];
+
+	switch ( format ){
+
+	case PS_FORMAT_TEXT:
+		mpx_printf("\n");
+		mpx_printf(" ===");
+		mpx_printf(" =======================  =====  ====  ========  ==========");
+		mpx_printf("  ============\n");
+		mpx_printf("    ");
+		mpx_printf(" Process Name             Class  Prio  Mem Size      Handle");
+		mpx_printf("  State\n");
+		mpx_printf(" ===");
+		mpx_printf(" =======================  =====  ====  ========  ==========");
+		mpx_printf("  ============\n");
+		break;
+
+	case PS_FORMAT_CSV:
+		mpx_printf("name,class,priority,state,memory_size,stack_size,"
+			"handle\n");
+		break;
+
+	case PS_FORMAT_JSON:
+		/* Each JSON line stands alone; there is no header. */
+		break;
+
+	case PS_FORMAT_BIN:
+		memcpy( header, "MPXP", 4 );
+		header[4] = PS_BIN_VERSION;
+		header[5] = PS_BIN_RECORD_SIZE;
+		put_le( &header[6], count, 4 );
+		mpx_write( (char *)header, PS_BIN_HEADER_SIZE );
+		break;
+	}
+}
+
+
+/*! Switches the terminal's output between binary and text mode, around a
+ *  binary listing.
+ *
+ *  On DOS, stdout is in text mode, which would write each 0x0A byte of a
+ *  record as 0x0D 0x0A.  Output already buffered is flushed first, while
+ *  the mode it was meant for is still set.  Elsewhere, this only flushes.
+ */
+static void ps_binary_output( int binary )
+{
+	mpx_flush();
+#ifdef __TURBOC__
+	fflush( stdout );
+	setmode( fileno(stdout), binary ? O_BINARY : O_TEXT );
+#endif
+}
+
+
+/*! Prints an underlined section title, in the text format. */
+static void ps_print_section( char *title )
+{
+	static char dashes[] =
+		"------------------------------------------------------------";
+
+	mpx_printf("\n  %s\n  %.*s\n", title, (int)strlen(title), dashes);
+}
+
+
+/*! Prints each process group's share of the CPU: the share it is due
+ *  among the groups that have ready processes, and the share it has
+ *  recently received (see pcb_group_t::recent_ticks).
+ *
+ *  The ready processes are counted as they enter and leave the ready
+ *  queue (see pcb_group_t::ready), so the cost depends only on the
+ *  number of groups.
+ */
+static void print_group_shares( void )
+{
+	pcb_group_t		*group;
+	unsigned long		 total_weight = 0;
+	unsigned long		 total_ticks = 0;
+	unsigned long		 share;
+	int			 i;
+
+	for ( i = 0; i < PCB_MAX_GROUPS; i++ ){
+		group = get_group( i );
+		if ( group != NULL ){
+			if ( group->ready > 0 ){
+				total_weight += group->weight;
+			}
+			total_ticks += group->recent_ticks;
+		}
+	}
+
+	mpx_printf("    Group                       Weight  Procs  Ready"
+		"   Target  Received\n");
+	for ( i = 0; i < PCB_MAX_GROUPS; i++ ){
+		group = get_group( i );
+		if ( group == NULL ){
+			continue;
+		}
+		mpx_printf("    %-24s    %6u  %5u  %5u", group->name,
+			group->weight, group->members, group->ready);
+		if ( group->ready > 0 ){
+			share = group->weight * 1000UL / total_weight;
+			mpx_printf("   %3lu.%lu%%", share / 10, share % 10);
+		} else {
+			mpx_printf("        -");
+		}
+		if ( total_ticks > 0 ){
+			share = group->recent_ticks * 1000UL / total_ticks;
+			mpx_printf("    %3lu.%lu%%\n", share / 10, share % 10);
+		} else {
+			mpx_printf("         -\n");
+		}
+	}
+}
+
+
+/*! Prints the process groups' shares after a text listing, if there are
+ *  any groups besides the default one. */
+static void ps_print_groups( ps_format_t format )
+{
+	int i;
+
+	if ( format != PS_FORMAT_TEXT ){
+		return;
+	}
+	for ( i = 1; i < PCB_MAX_GROUPS; i++ ){
+		if ( get_group( i ) != NULL ){
+			ps_print_section( "Process groups:" );
+			print_group_shares();
+			return;
+		}
+	}
+}
+
+
+/*! Lists the PCBs in one queue that pass the filter, in queue order.
+ *
+ *  At most \c limit PCBs are listed.  If \c print is zero, nothing is
+ *  printed, and the PCBs are only counted.
+ *
+ *  @return	Returns the number of PCBs listed.
+ */
+static unsigned long ps_list_queue(
+	pcb_queue_t	*queue,
+	ps_filter_t	*filter,
+	int		 reverse,
+	unsigned long	 limit,
+	ps_format_t	 format,
+	int		 print
+)
+{
+	pcb_queue_node_t	*node;
+	unsigned long		 count = 0;
+
+	for ( node = ps_scan_first( queue, filter, reverse );
+	      node != NULL && count < limit;
+	      node = ps_scan_next( queue, node, filter, reverse ) ){
+		if ( ps_matches( node->pcb, filter ) ){
+			if ( print ){
+				ps_print_pcb( node->pcb, format );
+			}
+			count++;
+		}
+	}
+
+	return count;
+}
+
+
+/*! Restores the heap property after heap[i] has been added or made worse.
+ *
+ *  The heaps built by ps_select() keep the PCB that would be listed last at
+ *  the root, so it is the one to drop when a better PCB comes along.
+ */
+static void ps_heap_up( pcb_t *heap[], long i, ps_key_t key )
+{
+	pcb_t	*pcb = heap[i];
+	long	 parent;
+
+	while ( i > 0 ){
+		parent = (i - 1) / 2;
+		if ( ! ps_before( heap[parent], pcb, key ) ){
+			break;
+		}
+		heap[i] = heap[parent];
+		i = parent;
+	}
+	heap[i] = pcb;
+}
+
+
+/*! Restores the heap property after heap[i] has been replaced by a PCB
+ *  that would be listed earlier. */
+static void ps_heap_down( pcb_t *heap[], long size, long i, ps_key_t key )
+{
+	pcb_t	*pcb = heap[i];
+	long	 child;
+
+	for (;;){
+		child = 2*i + 1;
+		if ( child >= size ){
+			break;
+		}
+		if ( child+1 < size && ps_before( heap[child], heap[child+1], key ) ){
+			child++;
+		}
+		if ( ! ps_before( pcb, heap[child], key ) ){
+			break;
+		}
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = pcb;
+}
+
+
+/*! Finds the first \c capacity PCBs that pass the filter, sorted by \c key.
+ *
+ *  This keeps the best PCBs seen so far in a bounded heap, so it costs
+ *  O(n log capacity) for n candidates.  When sorting by priority, the scan
+ *  of a PRIORITY queue stops as soon as its PCBs can no longer make the
+ *  list, so for small lists the cost depends on the size of the list, not
+ *  the size of the queue.
+ *
+ *  @return	Returns the number of PCBs found; they are left in heap[],
+ *		in the order they should be listed.
+ */
+static long ps_select(
+	/*! [in] The queues to search, terminated by NULL. */
+	pcb_queue_t	*selected[],
+	ps_filter_t	*filter,
+	ps_key_t	 key,
+	/*! [out] Room for at least \c capacity PCBs. */
+	pcb_t		*heap[],
+	long		 capacity
+)
+{
+	pcb_queue_node_t	*node;
+	pcb_t			*pcb;
+	long			 size = 0;
+	long			 last;
+	int			 i;
+
+	for ( i = 0; selected[i] != NULL; i++ ){
+		for ( node = ps_scan_first( selected[i], filter, 0 );
+		      node != NULL;
+		      node = ps_scan_next( selected[i], node, filter, 0 ) ){
+			pcb = node->pcb;
+
+			if ( size == capacity && key == PS_KEY_PRIO &&
+			     selected[i]->sort_order == PRIORITY &&
+			     pcb->priority < heap[0]->priority ){
+				/* The rest of this queue ranks lower still. */
+				break;
+			}
+
+			if ( ! ps_matches( pcb, filter ) ){
+				continue;
+			}
+
+			if ( size < capacity ){
+				heap[size] = pcb;
+				ps_heap_up( heap, size, key );
+				size++;
+			} else if ( ps_before( pcb, heap[0], key ) ){
+				heap[0] = pcb;
+				ps_heap_down( heap, size, 0, key );
+			}
+		}
+	}
+
+	/* Heapsort: move the PCB to be listed last to the end, repeatedly. */
+	for ( last = size-1; last > 0; last-- ){
+		pcb = heap[0];
+		heap[0] = heap[last];
+		heap[last] = pcb;
+		ps_heap_down( heap, last, 0, key );
+	}
+
+	return size;
+}
+
+
+/*! Implements the <tt>ps</tt> shell command.
+ *
+ * Processes can be selected by state, class, priority range and name
+ * prefix; see help/ps.hlp.  Without a sort key, they are listed in queue
+ * order, section by section; with one, the matches from all of the
+ * selected queues are listed together, best first.
+ */
+void mpxcmd_ps ( int argc, char *argv[] )
+{
+	int i;
+	int parsed;
+	pcb_t *specified_pcb;
+
+	int print_ready		= 0;
+	int print_suspended	= 0;
+	int print_blocked	= 0;
+	int print_in_reverse	= 0;
+
+	ps_format_t format	= PS_FORMAT_TEXT;
+	ps_key_t key		= PS_KEY_QUEUE;
+	unsigned long limit	= (unsigned long)-1;
+	ps_filter_t filter;
+
+	/* The queues to list, in order, terminated by NULL; and their
+	 * states. */
+	pcb_queue_t *selected[6];
+	process_state_t selected_state[5];
+	int num_selected;
+
+	/* Number of PCBs to be listed, and still to be listed. */
+	unsigned long count;
+	unsigned long remaining;
+
+	/* For sorted listings: the PCBs to list, and room for how many. */
+	pcb_t **heap;
+	long capacity;
+	long j;
+
+	char title[40];
+
+	if ( argc == 3 && strcmp("--", argv[2]) == 0 ){
+		specified_pcb = lookup_process( argv[1] );
+		if (specified_pcb == NULL ){
+			mpx_printf("ERROR: Specified process does not exist.\n");
+			return;
+		}
+		print_pcb_info( specified_pcb );
+		return;
+	}
+
+	if ( argc == 2 && argv[1][0] != '-' ){
+		specified_pcb = lookup_process( argv[1] );
+		if (specified_pcb == NULL ){
+			mpx_printf("ERROR: Specified process does not exist.\n");
+			return;
+		}
+		print_pcb_info( specified_pcb );
+		return;
+	}
+
+	ps_init_filter( &filter );
+
+	for ( i = 1; i < argc; i++ ) {
+		if ( strcmp("-r", argv[i]) == 0 ){
+			print_ready = 1;
+		} else
+		if (strcmp( "-s", argv[i]) == 0 ){
+			print_suspended = 1;
+		} else
+		if (strcmp( "-b", argv[i]) == 0 ){
+			print_blocked = 1;
+		} else
+		if (strcmp( "-a", argv[i]) == 0 ){
+			print_ready = 1;
+			print_suspended = 1;
+			print_blocked = 1;
+		} else
+		if (strcmp( "-R", argv[i]) == 0 ){
+			print_in_reverse = 1;
+		} else
+		if (strcmp( "-o", argv[i]) == 0 && i+1 < argc ){
+			i++;
+			if ( strcmp( "text", argv[i] ) == 0 ){
+				format = PS_FORMAT_TEXT;
+			} else if ( strcmp( "csv", argv[i] ) == 0 ){
+				format = PS_FORMAT_CSV;
+			} else if ( strcmp( "json", argv[i] ) == 0 ){
+				format = PS_FORMAT_JSON;
+			} else if ( strcmp( "bin", argv[i] ) == 0 ){
+				format = PS_FORMAT_BIN;
+			} else {
+				mpx_printf("ERROR: Unknown output format '%s'.\n",
+					argv[i]);
+				mpx_printf("Valid formats are text, csv, json, and bin.\n");
+				return;
+			}
+		} else
+		if ( (parsed = ps_parse_filter( argc, argv, &i, &filter )) != 0 ){
+			if ( parsed < 0 ){
+				return;
+			}
+		} else
+		if (strcmp( "-l", argv[i]) == 0 && i+1 < argc ){
+			i++;
+			if ( atol( argv[i] ) <= 0 ){
+				mpx_printf("ERROR: Invalid limit '%s'.\n", argv[i]);
+				return;
+			}
+			limit = (unsigned long)atol( argv[i] );
+		} else
+		if (strcmp( "-k", argv[i]) == 0 && i+1 < argc ){
+			i++;
+			if ( strcmp( "queue", argv[i] ) == 0 ){
+				key = PS_KEY_QUEUE;
+			} else if ( strcmp( "prio", argv[i] ) == 0 ){
+				key = PS_KEY_PRIO;
+			} else if ( strcmp( "name", argv[i] ) == 0 ){
+				key = PS_KEY_NAME;
+			} else if ( strcmp( "mem", argv[i] ) == 0 ){
+				key = PS_KEY_MEM;
+			} else {
+				mpx_printf("ERROR: Unknown sort key '%s'.\n", argv[i]);
+				mpx_printf("Valid keys are queue, prio, name, and mem.\n");
+				return;
+			}
+		}
+		else {
+			mpx_printf("ERROR: Invalid argument '%s'.", argv[i]);
+			mpx_printf("Remember, flags are case-sensitive.\n");
+			return;
+		}
+	}
+
+	num_selected = ps_select_queues( print_ready, print_suspended,
+		print_blocked, selected, selected_state );
+
+	/* Unsorted: list each queue in turn, in queue order. */
+	if ( key == PS_KEY_QUEUE ){
+
+		/* The binary header needs the count up front; without any
+		 * filters, the queue lengths give it. */
+		count = 0;
+		if ( format == PS_FORMAT_BIN ){
+			for ( i = 0; i < num_selected; i++ ){
+				if ( filter.class < 0 && filter.prefix == NULL &&
+				     filter.group < 0 &&
+				     filter.prio_lo == PRIORITY_MIN &&
+				     filter.prio_hi == PRIORITY_MAX ){
+					count += selected[i]->length;
+				} else {
+					count += ps_list_queue( selected[i],
+						&filter, print_in_reverse,
+						limit - count, format, 0 );
+				}
+			}
+			if ( count > limit ){
+				count = limit;
+			}
+		}
+
+		if ( format == PS_FORMAT_BIN ){
+			ps_binary_output( 1 );
+		}
+		ps_print_header( format, count );
+
+		remaining = limit;
+		for ( i = 0; i < num_selected; i++ ){
+			if ( format == PS_FORMAT_TEXT ){
+				sprintf( title, "Processes in state %s%s:",
+					process_state_to_string( selected_state[i] ),
+					selected[i] == get_realtime_queue() ?
+						" (real-time)" : "" );
+				ps_print_section( title );
+			}
+			remaining -= ps_list_queue( selected[i], &filter,
+				print_in_reverse, remaining, format, 1 );
+		}
+		ps_print_groups( format );
+		if ( format == PS_FORMAT_BIN ){
+			ps_binary_output( 0 );
+		}
+		return;
+	}
+
+	/* Sorted: find the best matches in all of the selected queues. */
+	capacity = 0;
+	for ( i = 0; i < num_selected; i++ ){
+		capacity += selected[i]->length;
+	}
+	if ( (unsigned long)capacity > limit ){
+		capacity = (long)limit;
+	}
+	if ( (unsigned long)capacity > ((size_t)-1) / sizeof(pcb_t *) ){
+		mpx_printf("ERROR: Too many processes to sort; ");
+		mpx_printf("use -l to list fewer.\n");
+		return;
+	}
+
+	heap = NULL;
+	if ( capacity > 0 ){
+		heap = (pcb_t **)sys_alloc_mem_nz(
+			(size_t)capacity * sizeof(pcb_t *) );
+		if ( heap == NULL ){
+			mpx_printf("ERROR: Not enough memory to sort; ");
+			mpx_printf("use -l to list fewer.\n");
+			return;
+		}
+	}
+
+	count = ps_select( selected, &filter, key, heap, capacity );
+
+	if ( format == PS_FORMAT_BIN ){
+		ps_binary_output( 1 );
+	}
+	ps_print_header( format, count );
+	if ( format == PS_FORMAT_TEXT ){
+		sprintf( title, "Processes by %s:",
+			key == PS_KEY_PRIO ? "priority" :
+			key == PS_KEY_NAME ? "name"     : "memory size" );
+		ps_print_section( title );
+	}
+	for ( j = 0; j < (long)count; j++ ){
+		ps_print_pcb( heap[j], format );
+	}
+	ps_print_groups( format );
+	if ( format == PS_FORMAT_BIN ){
+		ps_binary_output( 0 );
+	}
+
+	if ( heap != NULL ){
+		sys_free_mem( heap );
+	}
+}
+
+
+/*! Implements the <tt>renice</tt> shell command.
+ *
+ * Changes the priority of the named processes, or of every process that
+ * passes a filter like the one <tt>ps</tt> uses; see help/renice.hlp.
+ * Each change takes constant time (see set_pcb_priority()), and a filter
+ * on a priority range only visits that part of the ready queues.
+ */
+void mpxcmd_renice ( int argc, char *argv[] )
+{
+	int		 priority;
+	int		 i;
+	int		 parsed;
+	pcb_t		*pcb;
+	unsigned long	 changed = 0;
+	int		 errors = 0;
+
+	/* For renicing by filter: */
+	int			 by_filter = 0;
+	int			 ready = 0;
+	int			 suspended = 0;
+	int			 blocked = 0;
+	ps_filter_t		 filter;
+	pcb_queue_t		*selected[6];
+	process_state_t		 selected_state[5];
+	pcb_queue_node_t	*node;
+	pcb_queue_node_t	*next;
+
+	if ( argc < 3 ){
+		mpx_printf("ERROR: Wrong number of arguments to renice.\n");
+		mpx_printf("       Type 'help renice' for usage information.\n");
+		return;
+	}
+
+	priority = atoi( argv[1] );
+	if ( priority < PRIORITY_MIN || priority > PRIORITY_MAX ){
+		mpx_printf("ERROR: Invalid priority specified.\n");
+		mpx_printf("Priority must be between -127 and 128 (inclusive).\n");
+		return;
+	}
+
+	/* renice <priority> <name> [<name> ...] */
+	if ( argv[2][0] != '-' ){
+		for ( i = 2; i < argc; i++ ){
+			pcb = lookup_process( argv[i] );
+			if ( pcb == NULL ){
+				mpx_printf("ERROR: Process '%s' does not exist.\n",
+					argv[i]);
+				errors++;
+				continue;
+			}
+			if ( pcb->priority != priority ){
+				set_pcb_priority( pcb, priority );
+				changed++;
+			}
+		}
+		mpx_printf("Success: %lu process(es) changed to priority %d.\n",
+			changed, priority);
+		return;
+	}
+
+	/* renice <priority> [-r|-s|-b|-a] [-c class] [-p lo:hi] [-n prefix] */
+	ps_init_filter( &filter );
+	for ( i = 2; i < argc; i++ ){
+		if ( strcmp( "-r", argv[i] ) == 0 ){
+			ready = 1;
+		} else if ( strcmp( "-s", argv[i] ) == 0 ){
+			suspended = 1;
+		} else if ( strcmp( "-b", argv[i] ) == 0 ){
+			blocked = 1;
+		} else if ( strcmp( "-a", argv[i] ) == 0 ){
+			ready = suspended = blocked = 1;
+		} else if ( (parsed = ps_parse_filter( argc, argv, &i, &filter )) != 0 ){
+			if ( parsed < 0 ){
+				return;
+			}
+			by_filter = 1;
+		} else {
+			mpx_printf("ERROR: Invalid argument '%s'.", argv[i]);
+			mpx_printf("Remember, flags are case-sensitive.\n");
+			return;
+		}
+	}
+
+	/* Renicing every process takes an explicit -a. */
+	if ( !by_filter && !ready && !suspended && !blocked ){
+		mpx_printf("ERROR: No processes selected.\n");
+		return;
+	}
+
+	ps_select_queues( ready, suspended, blocked, selected, selected_state );
+
+	for ( i = 0; selected[i] != NULL; i++ ){
+		/* A PCB that is moved may be met again further down the queue,
+		 * but by then it already has the new priority; so it is enough
+		 * to step past each PCB before moving it. */
+		for ( node = ps_scan_first( selected[i], &filter, 0 );
+		      node != NULL;
+		      node = next ){
+			next = ps_scan_next( selected[i], node, &filter, 0 );
+			pcb = node->pcb;
+			if ( pcb->priority != priority &&
+			     ps_matches( pcb, &filter ) ){
+				set_pcb_priority( pcb, priority );
+				changed++;
+			}
+		}
+	}
+
+	mpx_printf("Success: %lu process(es) changed to priority %d.\n",
+		changed, priority);
+}
+
+
+/*! Implements the <tt>create_pcb</tt> shell command.
+ *
+ * A real-time process (class R) also takes its period, budget, and
+ * optionally its deadline, in clock ticks; see set_pcb_realtime().  Any
+ * process may be put in a group other than the default one by ending the
+ * command with "-g" and the group's name.
+ *
+ * \attention This TEMPORARY command will be replaced later. */
+void mpxcmd_create_pcb ( int argc, char *argv[] )
+{
+	pcb_t		*new_pcb;
+	pcb_handle_t	 new_pcb_handle;
+	int		 new_pcb_priority;
+	process_class_t	 new_pcb_class;
+	pcb_queue_t	*new_pcb_dest_queue;
+	/* Real-time period, budget, and deadline. */
+	long		 rt_ticks[3];
+	int		 admitted;
+	int		 i;
+	int		 group = 0;
+
+	if ( argc > 2 && strcmp( argv[argc-2], "-g" ) == 0 ){
+		group = find_group( argv[argc-1] );
+		if ( group < 0 ){
+			mpx_printf("ERROR: Group '%s' does not exist.\n",
+				argv[argc-1]);
+			return;
+		}
+		argc -= 2;
+	}
+
+	if ( argc != 4 && argc != 6 && argc != 7 ){
+		mpx_printf("ERROR: Wrong number of arguments to create_pcb.\n");
+		return;
+	}
+
+	if ( strlen(argv[1]) > MAX_ARG_LEN ) {
+		mpx_printf("ERROR: Specified process name is too long.\n");
+		return;
+	}
+
+	if ( argv[1][0] == '#' ) {
+		/* Would be taken for a handle; see lookup_process(). */
+		mpx_printf("ERROR: Process names may not start with '#'.\n");
+		return;
+	}
+
+	new_pcb_priority = atoi(argv[3]);
+
+	if ( new_pcb_priority < -127 || new_pcb_priority > 128 ){
+		mpx_printf("ERROR: Invalid priority specified.\n");
+		mpx_printf("Priority must be between -127 and 128 (inclusive).\n");
+		return;
+	}
+	
+	if ( strlen(argv[2]) == 1 &&
+				(argv[2][0] == 'A' || argv[2][0] == 'a') ){
+		new_pcb_class = APPLICATION;
+	} else if ( strlen(argv[2]) == 1 &&
+				(argv[2][0] == 'S' || argv[2][0] == 's') ){
+		new_pcb_class = SYSTEM;
+	} else if ( strlen(argv[2]) == 1 &&
+				(argv[2][0] == 'R' || argv[2][0] == 'r') ){
+		new_pcb_class = REALTIME;
+	} else {
+		mpx_printf("ERROR: Invalid process class specified.\n");
+		return;
+	}
+
+	if ( ( new_pcb_class == REALTIME ) != ( argc > 4 ) ){
+		mpx_printf("ERROR: Wrong number of arguments to create_pcb.\n");
+		return;
+	}
+
+	rt_ticks[2] = 0;
+	for ( i = 4; i < argc; i++ ){
+		rt_ticks[i-4] = atol(argv[i]);
+		if ( rt_ticks[i-4] < 1 || rt_ticks[i-4] > RT_MAX_TICKS ){
+			mpx_printf("ERROR: Invalid real-time period, budget, or "
+				"deadline.\n");
+			mpx_printf("Each must be between 1 and %d ticks.\n",
+				RT_MAX_TICKS);
+			return;
+		}
+	}
+
+	new_pcb_handle = setup_pcb( argv[1], new_pcb_priority,
+		new_pcb_class == REALTIME ? APPLICATION : new_pcb_class,
+		group );
+
+	if ( new_pcb_handle == PCB_NO_HANDLE ){
+		mpx_printf("ERROR: Failure creating process.\n");
+		return;
+	}
+
+	new_pcb = get_pcb( new_pcb_handle );
+
+	if ( new_pcb_class == REALTIME ){
+		admitted = set_pcb_realtime( new_pcb, (unsigned int)rt_ticks[0],
+			(unsigned int)rt_ticks[1], (unsigned int)rt_ticks[2] );
+		if ( admitted <= 0 ){
+			free_pcb( new_pcb );
+			if ( admitted == 0 ){
+				mpx_printf("ERROR: A real-time process needs "
+					"budget <= deadline <= period.\n");
+			} else {
+				mpx_printf("ERROR: Not admitted; the real-time "
+					"load would exceed %d/%d.\n",
+					RT_LOAD_BOUND, RT_LOAD_SCALE);
+			}
+			return;
+		}
+	}
+
+	new_pcb_dest_queue = insert_pcb( new_pcb );
+
+	if ( new_pcb_dest_queue == NULL ){
+		mpx_printf("ERROR: Failure enqueuing new process.\n");
+	}
+
+	mpx_printf("Success: Process #%lu created.\n", new_pcb_handle);
+}
+
+
+/*! Implements the <tt>delete_pcb</tt> shell command.
+ *
+ * \attention This TEMPORARY command will be replaced later. */
+void mpxcmd_delete_pcb ( int argc, char *argv[] )
+{
+	pcb_t		*pcb;
+	pcb_queue_t	*retval;
+
+	if ( argc != 2 ){
+		mpx_printf("ERROR: Wrong number of arguments to create_pcb.\n");
+		return;
+	}
+
+	if ( strlen(argv[1]) > MAX_ARG_LEN || strlen(argv[1]) < 1 ){
+		mpx_printf("ERROR: Invalid process name.\n");
+		return;
+	}
+	
+	pcb = lookup_process( argv[1] );
+	if ( pcb == NULL ){
+		mpx_printf("ERROR: Specified process does not exist.\n");
+		return;
+	}
+
+	retval = remove_pcb( pcb );
+	if ( retval == NULL ){
+		mpx_printf("ERROR: Unspecified error removing PCB.\n");
+		return;
+	}
+
+	free_pcb( pcb );
+
+	mpx_printf("Success: PCB for process '%s' removed.\n", argv[1]);
+}
+
+
+/*! Implements the <tt>block</tt> shell command.
+ *
+ * \attention This TEMPORARY command will be replaced later. */
+void mpxcmd_block ( int argc, char *argv[] )
+{
+	pcb_t		*pcb;
+
+	if ( argc != 2 ){
+		mpx_printf("ERROR: Wrong number of arguments to block.\n");
+		return;
+	}
+
+	if ( strlen(argv[1]) > MAX_ARG_LEN || strlen(argv[1]) < 1 ){
+		mpx_printf("ERROR: Invalid process name.\n");
+		return;
+	}
+
+	pcb = lookup_process( argv[1] );
+	if ( pcb == NULL ){
+		mpx_printf("ERROR: Specified process does not exist.\n");
+		return;
+	}
+
+	if ( is_blocked(pcb) ){
+		mpx_printf("ERROR: Specified process is already blocked.\n");
+		return;
+	}
+
+	/* Block PCB, checking for error return. */
+	if ( ! block_pcb(pcb) ){
+		mpx_printf("ERROR: Unspecified error blocking process.");
+		return;
+	}
+
+	/* Let the user know that the operation was successful. */
+	mpx_printf("Success: Process '%s' is now blocked.\n", argv[1]);
+}
+
+
+/*! Implements the <tt>unblock</tt> shell command.
+ *
+ * \attention This TEMPORARY command will be replaced later. */
+void mpxcmd_unblock ( int argc, char *argv[] )
+{
+	pcb_t		*pcb;
+
+	if ( argc != 2 ){
+		mpx_printf("ERROR: Wrong number of arguments to unblock.\n");
+		return;
+	}
+
+	if ( strlen(argv[1]) > MAX_ARG_LEN || strlen(argv[1]) < 1 ){
+		mpx_printf("ERROR: Invalid process name.\n");
+		return;
+	}
+
+	pcb = lookup_process( argv[1] );
+	if ( pcb == NULL ){
+		mpx_printf("ERROR: Specified process does not exist.\n");
+		return;
+	}
+
+	if ( ! is_blocked(pcb) ){
+		mpx_printf("ERROR: Specified process is not blocked.\n");
+		return;
+	}
+
+	/* Unblock PCB, checking for error return. */
+	if ( ! unblock_pcb(pcb) ){
+		mpx_printf("ERROR: Unspecified error unblocking process.");
+		return;
+	}
+
+	/* Let the user know that the operation was successful. */
+	mpx_printf("Success: Process '%s' is now unblocked.\n", argv[1]);
+
+}
+
+
+/*! Implements the <tt>sched</tt> shell command.
+ *
+ * With no arguments, lists the scheduling policies, marking the one in
+ * charge of the ready queue; with a policy name, puts that one in charge,
+ * and then passes it any further arguments as settings.  The settings are
+ * checked first; if they are invalid, nothing changes.
+ */
+void mpxcmd_sched ( int argc, char *argv[] )
+{
+	sched_policy_t	*current = get_sched_policy();
+	int		 i;
+
+	if ( argc >= 2 ){
+		i = 0;
+		while ( sched_policies[i] != NULL &&
+			strcmp( sched_policies[i]->name, argv[1] ) != 0 ){
+			i++;
+		}
+		if ( sched_policies[i] == NULL ){
+			mpx_printf("ERROR: There is no scheduling policy '%s'.\n",
+				argv[1]);
+			return;
+		}
+		if ( argc > 2 && ( sched_policies[i]->tune == NULL ||
+			! sched_policies[i]->tune( NULL, argc - 2, argv + 2 ) ) ){
+			mpx_printf("ERROR: Invalid settings for scheduling policy "
+				"'%s'; nothing was changed.\n", argv[1]);
+			return;
+		}
+		if ( ! set_sched_policy( argv[1] ) ){
+			mpx_printf("ERROR: Scheduling policy '%s' could not be "
+				"started.\n", argv[1]);
+			return;
+		}
+		if ( argc > 2 ){
+			get_sched_policy()->tune( get_queue_by_state(READY),
+				argc - 2, argv + 2 );
+		}
+		mpx_printf("Success: Scheduling policy is now '%s'.\n",
+			argv[1]);
+		return;
+	}
+
+	for ( i = 0; sched_policies[i] != NULL; i++ ){
+		mpx_printf("  %c %-12s %s\n",
+			sched_policies[i] == current ? '*' : ' ',
+			sched_policies[i]->name,
+			sched_policies[i]->description);
+	}
+}
+
+
+/*! Implements the <tt>flush</tt> shell command.
+ *
+ * Writes out any output that is being held in the MPX output buffer or the
+ * batch-mode stdio buffer. */
+void mpxcmd_flush ( int argc, char *argv[] )
+{
+	mpx_flush();
+	fflush( stdout );
+}
+
+
+/*! Implements the <tt>rt</tt> shell command.
+ *
+ * Reports on the real-time processes: their load against the admission
+ * bound, and how many of their deadlines have been missed, in total and
+ * for each enqueued one. */
+void mpxcmd_rt ( int argc, char *argv[] )
+{
+	pcb_rt_stats_t		 stats;
+	pcb_queue_node_t	*node;
+	pcb_sched_t		*sched;
+	int			 i;
+
+	if ( argc != 1 ){
+		mpx_printf("ERROR: Wrong number of arguments to rt.\n");
+		return;
+	}
+
+	get_realtime_stats( &stats );
+
+	mpx_printf("Real-time: %u processes, load %u/%d (admitted up to "
+		"%d)\n", stats.processes, stats.load, RT_LOAD_SCALE,
+		RT_LOAD_BOUND);
+	mpx_printf("           %lu jobs, %lu deadlines missed\n",
+		stats.jobs, stats.misses);
+
+	if ( stats.processes == 0 ){
+		return;
+	}
+
+	mpx_printf("\n");
+	mpx_printf("    Name                        Period  Budget  Deadline"
+		"      Jobs    Missed\n");
+	for ( i = 0; i < 5; i++ ){
+		foreach_listitem( node, queues[i] ){
+			if ( node->pcb->class != REALTIME ){
+				continue;
+			}
+			sched = node->pcb->sched;
+			mpx_printf("    %-24s    %6u  %6u  %8u  %8lu  %8lu\n",
+				get_pcb_name(node->pcb), sched->rt_period,
+				sched->rt_budget, sched->rt_deadline,
+				sched->rt_jobs, sched->rt_misses);
+		}
+	}
+}
+
+
+/*! Implements the <tt>group</tt> shell command.
+ *
+ * With no arguments, lists the process groups and their shares of the CPU;
+ * otherwise creates, re-weights, or deletes a group, or moves processes
+ * into one.  See help/group.hlp.
+ */
+void mpxcmd_group ( int argc, char *argv[] )
+{
+	int		 group;
+	long		 weight;
+	char		*end;
+	pcb_t		*pcb;
+	unsigned long	 moved = 0;
+	int		 i;
+
+	if ( argc == 1 ){
+		print_group_shares();
+		return;
+	}
+
+	/* group -w <weight> <group> */
+	if ( strcmp( argv[1], "-w" ) == 0 ){
+		if ( argc != 4 ){
+			mpx_printf("ERROR: Wrong number of arguments to group.\n");
+			return;
+		}
+		weight = strtol( argv[2], &end, 10 );
+		if ( end == argv[2] || *end != '\0' || weight < 1 ||
+				weight > GROUP_WEIGHT_MAX ){
+			mpx_printf("ERROR: Invalid weight '%s'.\n", argv[2]);
+			mpx_printf("Weight must be between 1 and %d (inclusive).\n",
+				GROUP_WEIGHT_MAX);
+			return;
+		}
+		if ( set_group_weight( argv[3], (unsigned int)weight ) < 0 ){
+			mpx_printf("ERROR: Group '%s' could not be created; "
+				"there may be %d at most.\n", argv[3],
+				PCB_MAX_GROUPS);
+			return;
+		}
+		mpx_printf("Success: Group '%s' has weight %ld.\n", argv[3],
+			weight);
+		return;
+	}
+
+	/* group -d <group> */
+	if ( strcmp( argv[1], "-d" ) == 0 ){
+		if ( argc != 3 ){
+			mpx_printf("ERROR: Wrong number of arguments to group.\n");
+			return;
+		}
+		group = find_group( argv[2] );
+		if ( group < 0 ){
+			mpx_printf("ERROR: Group '%s' does not exist.\n", argv[2]);
+			return;
+		}
+		if ( ! delete_group( group ) ){
+			mpx_printf("ERROR: Group '%s' cannot be deleted while it "
+				"has processes, or if it is the default group.\n",
+				argv[2]);
+			return;
+		}
+		mpx_printf("Success: Group '%s' deleted.\n", argv[2]);
+		return;
+	}
+
+	/* group <group> <name> [<name> ...] */
+	if ( argc < 3 ){
+		mpx_printf("ERROR: Wrong number of arguments to group.\n");
+		mpx_printf("       Type 'help group' for usage information.\n");
+		return;
+	}
+	group = find_group( argv[1] );
+	if ( group < 0 ){
+		mpx_printf("ERROR: Group '%s' does not exist.\n", argv[1]);
+		return;
+	}
+	for ( i = 2; i < argc; i++ ){
+		pcb = lookup_process( argv[i] );
+		if ( pcb == NULL ){
+			mpx_printf("ERROR: Process '%s' does not exist.\n",
+				argv[i]);
+			continue;
+		}
+		if ( pcb->group != group ){
+			set_pcb_group( pcb, group );
+			moved++;
+		}
+	}
+	mpx_printf("Success: %lu process(es) moved to group '%s'.\n",
+		moved, argv[1]);
+}
+
+
+/*! Implements the <tt>mem</tt> shell command.
+ *
+ * Reports per-size-class statistics from the MPX memory allocator, and the
+ * occupancy of the PCB pool, whose chunks come from it. */
+void mpxcmd_mem ( int argc, char *argv[] )
+{
+	alloc_stats		stats[NUM_SIZE_CLASSES+1];
+	pcb_pool_stats_t	pool;
+	int			num_stats;
+	int			i;
+
+	if ( argc != 1 ){
+		mpx_printf("ERROR: Wrong number of arguments to mem.\n");
+		return;
+	}
+
+	num_stats = sys_alloc_stats( stats, NUM_SIZE_CLASSES+1 );
+
+	mpx_printf("\n");
+	mpx_printf("Block Size    In Use  High-Water    Allocs     Frees  Chunks\n");
+	mpx_printf("----------  --------  ----------  --------  --------  ------\n");
+	for ( i = 0; i < num_stats; i++ ){
+		if ( stats[i].block_size == 0 ){
+			mpx_printf("%10s", "large");
+		} else {
+			mpx_printf("%10u", (unsigned int)stats[i].block_size);
+		}
+		mpx_printf("  %8ld  %10ld  %8ld  %8ld  %6ld\n",
+			stats[i].in_use, stats[i].high_water,
+			stats[i].allocs, stats[i].frees, stats[i].chunks);
+	}
+
+	get_pcb_pool_stats( &pool );
+
+	mpx_printf("\n");
+	mpx_printf("PCB pool:  %lu in use, %lu free, %lu high-water mark\n",
+		pool.in_use, pool.capacity - pool.in_use, pool.high_water);
+	mpx_printf("           %lu slots in %lu chunks of %d\n",
+		pool.capacity, pool.chunks, PCB_POOL_CHUNK_SLOTS);
+}
+
+
+#ifdef DISPATCH_HOST
+/*! Number of times each process started by the <tt>dispatch</tt> command
+ *  yields the CPU. */
+static long dispatch_yields;
+
+
+/*! What each process started by the <tt>dispatch</tt> command runs: it
+ *  yields the CPU dispatch_yields times, and then ends. */
+static void dispatch_test_process( void )
+{
+	int	count = 0;
+	long	i;
+
+	for ( i = 0; i < dispatch_yields; i++ ){
+		sys_req( IDLE, NO_DEV, NULL, &count );
+	}
+}
+
+
+/*! Implements the <tt>dispatch</tt> shell command (host builds only).
+ *
+ * Creates a number of processes, each of which yields the CPU a number of
+ * times and then ends; dispatches them until they have all ended; and
+ * reports how long each switch from one process to the next took, on
+ * average.  The processes are dispatched by the scheduling policy in
+ * charge, so this also measures the policy.
+ */
+void mpxcmd_dispatch ( int argc, char *argv[] )
+{
+	/* Number of processes, and the times each one yields. */
+	long		 counts[2];
+	char		 name[MAX_ARG_LEN+1];
+	char		*end;
+	clock_t		 start;
+	double		 seconds;
+	unsigned long	 turns;
+	long		 i;
+
+	if ( argc > 3 ){
+		mpx_printf("ERROR: Wrong number of arguments to dispatch.\n");
+		return;
+	}
+
+	counts[0] = 16;
+	counts[1] = 100000;
+	for ( i = 1; i < argc; i++ ){
+		counts[i-1] = strtol( argv[i], &end, 10 );
+		if ( end == argv[i] || *end != '\0' || counts[i-1] < 1 ){
+			mpx_printf("ERROR: Invalid number '%s'.\n", argv[i]);
+			return;
+		}
+	}
+
+	/* Only processes made by create_process() can be dispatched. */
+	if ( peek_ready_pcb() != NULL ){
+		mpx_printf("ERROR: Processes are ready; dispatch only runs "
+			"processes of its own.\n");
+		mpx_printf("Block or suspend the ready processes first.\n");
+		return;
+	}
+
+	dispatch_yields = counts[1];
+	for ( i = 0; i < counts[0]; i++ ){
+		sprintf( name, "dispatch%d", (int)( i+1 ) );
+		if ( create_process( name, 0, APPLICATION, 0,
+				dispatch_test_process ) == PCB_NO_HANDLE ){
+			mpx_printf("ERROR: Failure creating process '%s'.\n",
+				name);
+
+			/* Let the ones already made end straight away. */
+			dispatch_yields = 0;
+			dispatch();
+			return;
+		}
+	}
+
+	start = clock();
+	turns = dispatch();
+	seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+
+	mpx_printf("Dispatched %ld processes for %lu turns in %.3f s "
+		"(\"%s\" policy).\n", counts[0], turns, seconds,
+		get_sched_policy()->name);
+	if ( turns > 0 ){
+		mpx_printf("Each switch took %.1f ns, on average.\n",
+			seconds * 1e9 / turns);
+	}
+}
+#endif
+
+
+#ifdef PCB_DEBUG
+/*! Implements the <tt>check_queues</tt> shell command (debug builds only).
+ *
+ * Given a number of turns, it first runs the scheduler for that many: each
+ * turn, the next ready process is dispatched, and preempted after one clock
+ * tick; and the queues are checked after every turn.  The turns taken from
+ * the real-time queue must also be within what the real-time processes'
+ * budgets allow: at most a budget per period, plus one job already under
+ * way, for each one.
+ */
+void mpxcmd_check_queues ( int argc, char *argv[] )
+{
+	int			 errors;
+	long			 turns = 0;
+	long			 turn;
+	char			*end;
+	pcb_t			*pcb;
+	pcb_queue_node_t	*node;
+	unsigned long		 rt_turns = 0;
+	unsigned long		 rt_allowed = 0;
+	int			 i;
+
+	if ( argc > 2 ){
+		mpx_printf("ERROR: Wrong number of arguments to check_queues.\n");
+		return;
+	}
+	if ( argc == 2 ){
+		turns = strtol( argv[1], &end, 10 );
+		if ( end == argv[1] || *end != '\0' || turns < 0 ){
+			mpx_printf("ERROR: Invalid number of turns '%s'.\n",
+				argv[1]);
+			return;
+		}
+	}
+
+	for ( turn = 1; turn <= turns; turn++ ){
+		if ( get_realtime_queue()->length > 0 ){
+			rt_turns++;
+		}
+		pcb = dequeue_ready_pcb();
+		if ( pcb == NULL ){
+			break;
+		}
+		advance_sched_clock( 1 );
+		preempt_pcb( pcb, 1 );
+
+		errors = check_pcb_queues();
+		if ( errors != 0 ){
+			mpx_printf("ERROR: %d inconsistencies found in PCB queues "
+				"after %ld turns.\n", errors, turn);
+			return;
+		}
+	}
+
+	errors = check_pcb_queues();
+	if ( errors != 0 ){
+		mpx_printf("ERROR: %d inconsistencies found in PCB queues.\n", errors);
+		return;
+	}
+
+	if ( rt_turns > 0 ){
+		for ( i = 0; i < 5; i++ ){
+			foreach_listitem( node, queues[i] ){
+				if ( node->pcb->class == REALTIME ){
+					rt_allowed += node->pcb->sched->rt_budget *
+						( (unsigned long)turns /
+						node->pcb->sched->rt_period + 2 );
+				}
+			}
+		}
+		if ( rt_turns > rt_allowed ){
+			mpx_printf("ERROR: Real-time processes ran %lu of %ld "
+				"turns; their budgets allow %lu.\n", rt_turns,
+				turns, rt_allowed);
+			return;
+		}
+	}
+
+	mpx_printf("PCB queues are consistent.\n");
+}
+#endif
+
+
+void init_commands(void)
+{
+	/* R1 commands */
+	add_command("date", mpxcmd_date);
 	add_command("exit", mpxcmd_exit);
 	add_command("help", mpxcmd_help);
 	add_command("ls", mpxcmd_ls);
@@ -777,4 +2321,22 @@ void init_commands(void)
 	add_command("delete_pcb", mpxcmd_delete_pcb);
 	add_command("block", mpxcmd_block);
 	add_command("unblock", mpxcmd_unblock);
+
+	/* Commands added since R2; the R1 and R2 commands keep their
+	 * abbreviations (e.g., "s" still runs suspend, not sched). */
+	add_late_command("sched", mpxcmd_sched);
+	add_late_command("group", mpxcmd_group);
+
+	/* Diagnostic and batch-mode commands */
+	add_late_command("rt", mpxcmd_rt);
+	add_late_command("mem", mpxcmd_mem);
+	add_late_command("flush", mpxcmd_flush);
+#ifdef DISPATCH_HOST
+	add_late_command("dispatch", mpxcmd_dispatch);
+#endif
+
+#ifdef PCB_DEBUG
+	/* Debugging commands */
+	add_late_command("check_queues", mpxcmd_check_queues);
+#endif
 }
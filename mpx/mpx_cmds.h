@@ -2,17 +2,20 @@
 #define MPX_CMDS_H_GUARD
 
 #include "pcb.h"
+#include <stddef.h>
 extern pcb_queue_t *queues[];
 
-/*! Node type for a singly-linked list of MPX commands. */
+/*! Entry in the (sorted) table of MPX commands. */
 struct mpx_command {
 	char *name;
 	void (*function)(int argc, char *argv[]);
-	struct mpx_command *next;
+	/*! Length of the shortest abbreviation that runs the command. */
+	size_t min_len;
 };
 
 void init_commands(void); 
 void add_command( char *name, void (*function)(int argc, char *argv[]) );
+void add_late_command( char *name, void (*function)(int argc, char *argv[]) );
 void dispatch_command( char *name, int argc, char *argv[] );
 
 void mpxcmd_commands( int argc, char *argv[] );
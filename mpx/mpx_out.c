@@ -0,0 +1,244 @@
+/*!
+ * @file	mpx_out.c
+ * @brief	Buffered output to the MPX terminal
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ *
+ * All MPX output to the terminal goes through this module instead of
+ * printf().  Text is appended to a single buffer, and the buffer is handed
+ * to sys_req() in one WRITE when it fills up, or when mpx_flush() is called;
+ * text too long for what is left of the buffer goes out with it, in one
+ * sys_writev().
+ *
+ * Output is only flushed at those points, so anything that reads from the
+ * terminal (the shell prompt, the pager, confirmation questions) must call
+ * mpx_flush() first, or the user will not see what they are answering.
+ * Likewise, anything that writes to the terminal other than through this
+ * module (e.g., clearing the screen) must flush first to keep the output in
+ * order.
+ */
+
+
+#include "mpx_out.h"
+#include "mpx_supt.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+
+/* Turbo C's va_list is a plain pointer, and it has no va_copy(). */
+#ifndef va_copy
+#define va_copy(dest, src)	( (dest) = (src) )
+#endif
+
+
+/*! Output that has not yet been written to the terminal.
+ *
+ * One extra byte is left for the '\\0' that vsprintf() and vsnprintf()
+ * write. */
+static char out_buf[MPX_OUT_BUF_SIZE+1];
+
+/*! Number of bytes of out_buf that are in use. */
+static int out_len = 0;
+
+/*! Number of newlines ever written through this module; see mpx_out_lines().
+ */
+static unsigned long out_lines = 0;
+
+
+/*! Counts the newlines in len bytes of text, starting at text. */
+static unsigned long count_newlines( const char *text, int len )
+{
+	unsigned long	 lines = 0;
+	const char	*end = text + len;
+
+	while ( (text = memchr(text, '\n', end - text)) != NULL ){
+		lines++;
+		text++;
+	}
+
+	return lines;
+}
+
+
+/*! Writes all buffered output to the terminal.
+ *
+ * @return	Returns zero on success, or the (negative) error code from
+ *		sys_req().  The buffer is emptied either way.
+ */
+int mpx_flush( void )
+{
+	int	count;
+	int	retval;
+
+	if ( out_len == 0 ){
+		return 0;
+	}
+
+	count = out_len;
+	out_len = 0;
+
+	retval = sys_req( WRITE, TERMINAL, out_buf, &count );
+	if ( retval < 0 ){
+		return retval;
+	}
+
+	return 0;
+}
+
+
+/*! Formats text into the free part of out_buf, if it fits there; if not,
+ *  out_buf may be left with part of it, past out_len.
+ *
+ * Turbo C has no vsnprintf(), so there the text is measured first, by
+ * formatting it to the NUL device, and only formatted into out_buf if it
+ * fits.
+ *
+ * @return	Returns the length of the text, whether it fit or not; or a
+ *		negative number if it could not be formatted.
+ *
+ * @private
+ */
+static int format_into_buf( const char *format, va_list args )
+{
+#ifdef __TURBOC__
+	static FILE	*nul = NULL;
+	va_list		 args_copy;
+	int		 len;
+
+	if ( nul == NULL && (nul = fopen("NUL", "w")) == NULL ){
+		return -1;
+	}
+
+	va_copy( args_copy, args );
+	len = vfprintf( nul, format, args_copy );
+	va_end( args_copy );
+
+	if ( len >= 0 && len <= MPX_OUT_BUF_SIZE - out_len ){
+		vsprintf( out_buf + out_len, format, args );
+	}
+	return len;
+#else
+	return vsnprintf( out_buf + out_len, MPX_OUT_BUF_SIZE - out_len + 1,
+		format, args );
+#endif
+}
+
+
+/*! This function replaces \c printf() for all MPX terminal output.
+ *
+ * There is no limit on the length of the text.
+ *
+ * @return	Returns the number of bytes output.
+ */
+int mpx_printf( const char *format, ... )
+{
+	int	bytes_written;
+	va_list	args;
+
+	va_start(args, format);
+	bytes_written = mpx_vprintf(format, args);
+	va_end(args);
+
+	return bytes_written;
+}
+
+
+/*! Same as mpx_printf(), but takes a va_list, like \c vprintf().
+ */
+int mpx_vprintf( const char *format, va_list args )
+{
+	int	 bytes_written;
+	char	*text;
+	va_list	 args_copy;
+
+	va_copy( args_copy, args );
+	bytes_written = format_into_buf( format, args_copy );
+	va_end( args_copy );
+	if ( bytes_written <= 0 ){
+		return bytes_written;
+	}
+
+	/* If it did not fit, flush and try again; if it cannot fit even in
+	 * an empty buffer, format it on its own and write that. */
+	if ( bytes_written > MPX_OUT_BUF_SIZE - out_len ){
+		mpx_flush();
+
+		if ( bytes_written > MPX_OUT_BUF_SIZE ){
+			text = (char *)sys_alloc_mem_nz( bytes_written + 1 );
+			if ( text == NULL ){
+				return -1;
+			}
+			vsprintf( text, format, args );
+			mpx_write( text, bytes_written );
+			sys_free_mem( text );
+			return bytes_written;
+		}
+
+		va_copy( args_copy, args );
+		format_into_buf( format, args_copy );
+		va_end( args_copy );
+	}
+
+	out_lines += count_newlines( out_buf + out_len, bytes_written );
+	out_len += bytes_written;
+
+	return bytes_written;
+}
+
+
+/*! Outputs a string as-is (like \c fputs(); no newline is added).
+ *
+ * @return	Returns the number of bytes output.
+ */
+int mpx_print( const char *str )
+{
+	return mpx_write( str, strlen(str) );
+}
+
+
+/*! Outputs \c len bytes from \c buf as-is.
+ *
+ * Unlike mpx_printf(), there is no limit on the length.  Text that does not
+ * fit in what is left of the buffer is not copied into it: the buffered
+ * output and the text are written together, with one sys_writev().
+ *
+ * @return	Returns the number of bytes output (i.e., \c len).
+ */
+int mpx_write( const char *buf, int len )
+{
+	io_vec	iov[2];
+
+	if ( len <= 0 ){
+		return len;
+	}
+
+	out_lines += count_newlines( buf, len );
+
+	if ( len <= MPX_OUT_BUF_SIZE - out_len ){
+		memcpy( out_buf + out_len, buf, len );
+		out_len += len;
+		return len;
+	}
+
+	iov[0].buf_p = out_buf;
+	iov[0].count = out_len;
+	iov[1].buf_p = (char *)buf;
+	iov[1].count = len;
+	out_len = 0;
+
+	sys_writev( TERMINAL, iov, 2 );
+
+	return len;
+}
+
+
+/*! Tells how many newlines have been output so far.
+ *
+ * The pager takes the difference between two calls to find out how many
+ * rows of the screen have been used, however the text was output.
+ */
+unsigned long mpx_out_lines( void )
+{
+	return out_lines;
+}
@@ -0,0 +1,31 @@
+#ifndef MPX_OUT_H_GUARD
+#define MPX_OUT_H_GUARD
+
+/*!
+ * @file	mpx_out.h
+ * @brief	Buffered output to the MPX terminal
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ */
+
+
+#include <stdarg.h>
+
+
+/*! Size of the terminal output buffer (in bytes).
+ *
+ * The whole buffer is handed to sys_req() in one WRITE, so it must fit in an
+ * int count. */
+#ifndef MPX_OUT_BUF_SIZE
+#define MPX_OUT_BUF_SIZE	4096
+#endif
+
+int		mpx_printf	( const char *format, ... );
+int		mpx_vprintf	( const char *format, va_list args );
+int		mpx_print	( const char *str );
+int		mpx_write	( const char *buf, int len );
+int		mpx_flush	( void );
+unsigned long	mpx_out_lines	( void );
+
+
+#endif
@@ -28,6 +28,9 @@
 #include "mpx_supt.h"
 #include "mpx_util.h"
 #include "mpx_cmds.h"
+#include "pager.h"
+#include "mpx_out.h"
+#include <stdio.h>
 #include <string.h>
 
 
@@ -43,38 +46,41 @@ void mpx_setprompt( char *new_prompt ){
 	if (mpx_prompt_string != NULL) {
 		sys_free_mem(mpx_prompt_string);
 	}
-	mpx_prompt_string = (char *)sys_alloc_mem(strlen(new_prompt)+1);
+	mpx_prompt_string = (char *)sys_alloc_mem_nz(strlen(new_prompt)+1);
 	strcpy(mpx_prompt_string, new_prompt);
 }
 
 
-/*! This function implements the MPX shell (command-line user interface).
+/*! @brief Non-zero while MPX is running a script in batch mode. */
+static int batch_mode = 0;
+
+
+/*! @brief Tells whether MPX is running a script in batch mode.
  *
- * mpx_shell() never returns!
+ * In batch mode there is no user at the terminal: commands should not ask
+ * for confirmation, and output is buffered rather than paged. */
+int mpx_batch_mode( void ){
+	return batch_mode;
+}
+
+
+/*! Tokenizes and runs a single command line.
  *
- * \bug A command should be able to depend on argv[argc] == NULL, but we do
- * not currently implement this feature.
+ * The command line is tokenized in place: argv[] is an array of pointers
+ * into cmdline, on the stack, so running a command costs no heap
+ * operations.  As with main(), argv[argc] is always NULL.
  *
+ * Blank lines are ignored; errors in the command line are reported.
  */
-void mpx_shell(void) {
-
-	/* A buffer to hold the command line input by the user.
-	 * We include space for the \r, \n, and \0 characters, if any. */
-	char cmdline[ MAX_CMDLINE_LEN+2 ];
-
-	/* Buffer size argument for passing to sys_req(). */
-	int line_buf_size = MAX_CMDLINE_LEN;
-
-	/* Used to capture the return value of sys_req(). */
-	int err;
+void mpx_run_cmdline( char *cmdline ) {
 
 	/* argc to pass to MPX command; works like the one passed to main. */
 	int argc;
-	/* argv to pass to MPX command; works almost like the one passed to main
+	/* argv to pass to MPX command; works like the one passed to main.
 	 *
-	 * But there is one caveat: argv[argc] is undefined in my
-	 * implementation, not garanteed to be NULL. */
-	char **argv;
+	 * Each element points into cmdline; +1 for argv[0], +1 for the
+	 * terminating NULL. */
+	char *argv[ MAX_ARGS+2 ];
 
 	/* Temporary pointer for use in string tokenization. */
 	char *token;
@@ -83,107 +89,151 @@ void mpx_shell(void) {
 	 * environment. */
 	char *delims = "\t \n";
 
-	/* An index for use in for(;;) loops. */
-	int i;
-	/* An index for use in nested for(;;) loops. */
-	int j;
+	/* Remove trailing newline. */
+	mpx_chomp(cmdline);
 
-	/* A flag to track if a single argument was too long...
-	 * This is kind of a quick-and-dirty workaround for C not having
-	 * the 'continue LABEL' feature. */
-	int arg_too_long;
 
-	/* We must initialize the prompt string. */
-	mpx_setprompt(MPX_DEFAULT_PROMPT);
+	/* Tokenize the command line entered by the user + set argc. */
+	/* ********************************************************* */
 
-	/* Loop Forever; this is the REPL. */
-	/* This loop terminates only via the MPX 'exit' command. */
-	for(;;) {
+	/*****  NOTE:  argc includes argv[0], but MAX_ARGS does not! */
 
-		arg_too_long = 0;
+	argc = 0;
+	token = strtok( cmdline, delims );
 
-		/* Output the current MPX prompt string. */
-		printf("%s", mpx_prompt_string);
+	while ( token != NULL && argc < MAX_ARGS+1 ){
 
-		/* Read in a line of input from the user. */
-		sys_req( READ, TERMINAL, cmdline, &line_buf_size );
+		if (strlen(token) > MAX_ARG_LEN) {
+			/* This argument is too long. */
+			mpx_printf("ERROR: Argument too long. MAX_ARG_LEN is %d.\n",
+				MAX_ARG_LEN
+			);
+			return;
+		}
 
-		/* Remove trailing newline. */
-		mpx_chomp(cmdline);
+		argv[argc++] = token;
+		token = strtok( NULL, delims );
+	}
+	argv[argc] = NULL;
 
-		/* Allocate space for argv */
-		/* *********************** */
+	if ( token != NULL ){
+		/* Too many arguments. */
+		mpx_printf("ERROR: Too many arguments. MAX_ARGS is %d.\n", MAX_ARGS);
+		return;
+	}
+
+	if ( argc <= 0 ) {
+		/* Blank command; nothing to do. */
+		return;
+	}
+
+	/* Run the command, or print an error if it is invalid. */
+	dispatch_command( argv[0], argc, argv );
+}
 
-		/* +1 for argv[0] */
-		argv = (char **)sys_alloc_mem( sizeof(char**) * (MAX_ARGS+1) );
-		/* +1 for argv[0] */
-		for( i=0; i < MAX_ARGS+1; i++ ){				
-			/* +1 for \0 */
-			argv[i] = sys_alloc_mem(MAX_ARG_LEN+1);
-		}
 
+/*! This function implements the MPX shell (command-line user interface).
+ *
+ * mpx_shell() never returns!
+ */
+void mpx_shell(void) {
 
-		/* Tokenize the command line entered by the user + set argc. */
-		/* ********************************************************* */
+	/* A buffer to hold the command line input by the user.
+	 * We include space for the \r, \n, and \0 characters, if any. */
+	char cmdline[ MAX_CMDLINE_LEN+2 ];
 
-		/* 0 is a special value here for argc; a value > 0 after the
-		 * for loop indicates that tokenizing was successful and that
-		 * argc and argv contain valid data.
-		 * 
-		 *****  NOTE:  argc includes argv[0], but MAX_ARGS does not! */
+	/* Buffer size argument for passing to sys_req(). */
+	int line_buf_size = MAX_CMDLINE_LEN;
 
-		argc = 0; token = NULL;
+	/* We must initialize the prompt string. */
+	mpx_setprompt(MPX_DEFAULT_PROMPT);
 
-		for( i=0; i < MAX_ARGS+1; i++ ){
+	/* Loop Forever; this is the REPL. */
+	/* This loop terminates only via the MPX 'exit' command. */
+	for(;;) {
 
-			if (i==0) {
-				token = strtok( cmdline, delims );
-			} else {
-				token = strtok( NULL, delims );
-			}
+		/* Output the current MPX prompt string. */
+		mpx_print(mpx_prompt_string);
+		mpx_flush();
 
-			if (token == NULL) {
-				/* No more arguments. */
-				break;
-			}
+		/* Read in a line of input from the user. */
+		sys_req( READ, TERMINAL, cmdline, &line_buf_size );
 
-			if (strlen(token) > MAX_ARG_LEN) {
-				/* This argument is too long. */
-				arg_too_long = 1;
-				argc = 0;
-				break;
-			}
+		/* Run it. */
+		mpx_run_cmdline( cmdline );
+	}
+}
 
-			argc++;
-			strcpy( argv[i], token );
-		}
 
-		if ( arg_too_long ){
-			printf("ERROR: Argument too long. MAX_ARG_LEN is %d.\n",
-				MAX_ARG_LEN
-			);
-			continue;
-			/*! @bug Allocated memory not freed in error cases. */
-		}
+/*! This function runs a script of MPX shell commands, non-interactively.
+ *
+ * Each line of the script is run as if it had been typed at the shell, but
+ * no prompts are printed, the pager never stops for a keypress, and output
+ * is collected in large buffers that are written out when they fill, when
+ * the \c flush command is run, and when MPX exits.  (Interactively, the
+ * shell flushes the output buffer before every prompt instead.)
+ *
+ * A line longer than MAX_CMDLINE_LEN is reported, and skipped as a whole.
+ *
+ * When the script is exhausted, MPX exits; mpx_batch() never returns!
+ */
+void mpx_batch(
+	/*! [in] Name of the script file, or NULL to read standard input. */
+	char *script_name
+) {
 
-		if ( strtok( NULL, delims ) != NULL ){
-			/* Too many arguments. */
-			printf("ERROR: Too many arguments. MAX_ARGS is %d.\n", MAX_ARGS);
-			continue;
+	/* A buffer to hold each line of the script.
+	 * We include space for the \r, \n, and \0 characters, if any. */
+	char cmdline[ MAX_CMDLINE_LEN+3 ];
+
+	/* The script we are reading from. */
+	FILE *script;
+
+	/* Number of the line just read, and the next character after it. */
+	unsigned long line_number = 0;
+	int c;
+
+	if ( script_name == NULL ) {
+		script = stdin;
+	} else {
+		script = fopen( script_name, "r" );
+		if ( script == NULL ) {
+			mpx_printf("ERROR: Cannot open script '%s'.\n", script_name);
+			mpx_flush();
+			sys_exit();
 		}
+	}
 
-		if ( argc <= 0 ) {
-			/* Blank command; just re-print the prompt. */
+	/* Enter batch mode: no pager stops, fully-buffered output. */
+	batch_mode = 1;
+	pager_set_interactive( 0 );
+	setvbuf( stdout, NULL, _IOFBF, MPX_BATCH_BUF_SIZE );
+
+	while ( fgets( cmdline, sizeof(cmdline), script ) != NULL ) {
+		line_number++;
+
+		/* If there is no newline, and the script goes on, the line did
+		 * not fit; skip the rest of it, rather than run it as another
+		 * command. */
+		if ( strchr( cmdline, '\n' ) == NULL && !feof( script ) ) {
+			do {
+				c = getc( script );
+			} while ( c != '\n' && c != EOF );
+
+			mpx_printf("ERROR: Line %lu of the script is too long; "
+				"lines may be at most %d characters.\n",
+				line_number, MAX_CMDLINE_LEN);
 			continue;
 		}
 
-		/* Run the command, or print an error if it is invalid. */
-		dispatch_command( argv[0], argc, argv );
+		mpx_run_cmdline( cmdline );
+	}
 
-		/* Free the memory for the dynamically-allocated *argv[] */
-		for( i=0; i < MAX_ARGS+1; i++ ){
-			sys_free_mem( argv[i] );
-		}
-		sys_free_mem( argv );
+	/* End of script; write out any buffered output (sys_exit() flushes
+	 * the stdio buffer). */
+	if ( script != stdin ) {
+		fclose( script );
 	}
+	mpx_flush();
+	sys_exit();
 }
@@ -5,7 +5,13 @@
 /*! Defines the default prompt string for the MPX command-line user interface. */
 #define MPX_DEFAULT_PROMPT	"\nMPX$ "
 
+/*! Size of the output buffer used in batch mode (in bytes). */
+#define MPX_BATCH_BUF_SIZE	16384
+
 void mpx_shell(void);
+void mpx_batch(char *script_name);
+void mpx_run_cmdline(char *cmdline);
+int  mpx_batch_mode(void);
 void mpx_setprompt(char *new_prompt);
 
 #endif
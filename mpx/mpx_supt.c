@@ -18,6 +18,7 @@
 	Environment:      IBM-PC (XT, AT or PS/2)
 			MS-DOS 3.3 or later
 			TURBO-C 3.0 or TURBO-C++ 1.0 or later
+			or, without DOS services, a hosted C compiler
 
 	Compile using the LARGE MODEL and SS NOT equal to DS.
 	All addresses and pointers are "far", and
@@ -31,8 +32,11 @@
 		sys_exit
 		sys_set_vec
 		sys_req
+		sys_writev
 		sys_alloc_mem
+		sys_alloc_mem_nz
 		sys_free_mem
+		sys_alloc_stats
 		sys_get_date
 		sys_set_date
 		sys_open_dir
@@ -75,20 +79,54 @@ Change Log:
         09/30/93  jdm	modified for correct list of root directory
 	11/01/94  jdm	changed load file read to binary
 	09/18/95  jdm	fixed get_entry to default to current, not root
+	10/16/26  pp	O(1) sys_alloc_mem & sys_free_mem: block header
+			holds table index; free slots kept on a stack
+	10/16/26  pp	allocation table grows a page at a time,
+			replacing the fixed MAX_ALLOC entries
+	10/16/26  pp	size-class allocator: small blocks carved from
+			aligned chunks, per-class free lists & stats;
+			added sys_alloc_mem_nz, sys_alloc_stats
+	10/16/26  pp	terminal write in a single fwrite; added
+			sys_writev for gather writes
+	10/16/26  pp	host build: sys_set_vec keeps the handler, and
+			sys_req calls it directly
+	10/16/26  pp	host build: DOS headers and calls only under
+			Turbo C; date from the C clock, ANSI screen
+			control, no directories or program loading
 
 ************************************************************************/
 
 #include "mpx_supt.h"
 #include <stdlib.h>
+#include <errno.h>
+#ifdef __TURBOC__
 #include <dos.h>
 #include <dir.h>
-#include <errno.h>
 #include <conio.h>
 #include <alloc.h>
+#else
+#include <time.h>
+#endif
 
 #define VEC_ADDR (0x60L*4)
 
-#define MAX_ALLOC 200
+/* the allocation table is a directory of pages of entries;
+   pages are added as needed, up to the directory size */
+#define ALLOC_PAGE_SHIFT 8
+#define ALLOC_PAGE_SIZE (1 << ALLOC_PAGE_SHIFT)
+#ifndef MAX_ALLOC_PAGES
+#define MAX_ALLOC_PAGES 4096
+#endif
+
+/* every block is preceded by a header of this many bytes,
+   which keeps the block itself aligned */
+#define HDR_SIZE 16
+
+/* small blocks are carved from chunks of this many bytes */
+#define CHUNK_SIZE 8192
+
+/* largest block served from a size class */
+#define MAX_CLASS_SIZE 2048
 
 #define MAX_XPOS 79
 #define MAX_YPOS 24
@@ -104,6 +142,15 @@ typedef unsigned int word;
 typedef unsigned long longword;
 typedef byte *address;
 
+#ifndef __TURBOC__
+/* the date, as Turbo C's getdate returns it */
+struct date {
+	int da_year;
+	char da_day;
+	char da_mon;
+	};
+#endif
+
 typedef struct params {
 	int      op_code;
 	int      device_id;
@@ -116,13 +163,18 @@ typedef struct params {
 */
 
 	static longword vec_save;  /* saved interrupt vector */
+#ifndef __TURBOC__
+	static void (*sysc_vec)(); /* system call handler (host) */
+#endif
 	static int mod_code;                /* module code */                                           
 	static struct date sys_date;        /* MPX system date */
 
 	/* data structures for directory access */
         static char current_path[MAX_PATH_SIZE+1];
+#ifdef __TURBOC__
         static int num_entries;
         static struct ffblk file_block;
+#endif
 
         /* handler presence flags */
 	static flag sysc_hand;
@@ -131,12 +183,47 @@ typedef struct params {
 	static flag com_hand;
 
         /* memory allocation table */
-	static struct {
+	typedef struct alloc_entry {
 		void* original;
 		void* aligned;
-	} alloc_table[MAX_ALLOC];
-	static int alloc_ix;                /* current index */
-	static int num_alloc;               /* no. of allocated blocks */
+		long next_free;             /* next entry on free list */
+	} alloc_entry;
+	static alloc_entry *alloc_table[MAX_ALLOC_PAGES]; /* page dir. */
+	static long free_head;              /* first free entry, or -1 */
+	static long num_used;               /* no. of entries ever used */
+	static long num_alloc;              /* no. of allocated blocks */
+
+	/* entry number ix of the allocation table */
+#define ALLOC_ENTRY(ix) \
+		(alloc_table[(ix) >> ALLOC_PAGE_SHIFT][(ix) & (ALLOC_PAGE_SIZE-1)])
+
+	/* header stored in the HDR_SIZE bytes below each block */
+	typedef struct alloc_hdr {
+		long ix;                    /* index in alloc_table */
+		int cls;                    /* size class, or NUM_SIZE_CLASSES
+					       for a large block */
+	} alloc_hdr;
+
+#define BLOCK_HDR(p) ((alloc_hdr*) ((byte*) (p) - HDR_SIZE))
+
+	/* size classes: block sizes are multiples of 16, so every
+	   block carved from an aligned chunk is aligned too */
+	static size_t class_size[NUM_SIZE_CLASSES] = {
+		16, 32, 48, 64, 96, 128, 192, 256,
+		384, 512, 768, 1024, 1536, 2048
+	};
+	static byte class_of[MAX_CLASS_SIZE/16 + 1]; /* (size+15)/16 -> class */
+
+	/* per-class free lists and never-used remainder of newest chunk */
+	static struct {
+		byte *free_list;            /* freed blocks, linked through
+					       their first bytes */
+		byte *fresh;                /* next never-used slot */
+		int fresh_left;             /* no. of never-used slots */
+	} class_state[NUM_SIZE_CLASSES];
+
+	/* per-class statistics; the last entry covers large blocks */
+	static alloc_stats class_stats[NUM_SIZE_CLASSES+1];
 
 
 
@@ -149,12 +236,13 @@ typedef struct params {
 
 	Return value: error code, or OK if no error
 
-	Calls: getdate    
+	Calls: getdate (host: time, localtime)
 
 	Globals: mod_code
 		vec_save
 		sys_date
-		alloc_table, alloc_ix, num_alloc
+		alloc_table, free_head, num_used, num_alloc
+		class_of, class_state, class_stats
 		sysc_hand, term_hand, prt_hand, com_hand
 
 	Errors: none
@@ -163,6 +251,13 @@ int sys_init (    int      modules  /* module code */
 	     )
 
 {
+	int ix;                    /* temporary index */
+	int cls;                   /* size class index */
+#ifndef __TURBOC__
+	time_t now;                /* host clock */
+	struct tm *now_tm;         /* host date */
+#endif
+
 	mod_code = modules;
         vec_save = 0L;
 
@@ -173,14 +268,35 @@ int sys_init (    int      modules  /* module code */
 	prt_hand = FALSE;
 	com_hand = FALSE;
 
-	/* initialize allocation table */
-	for (alloc_ix=0; alloc_ix < MAX_ALLOC; alloc_ix++) {
-		alloc_table[alloc_ix].original = NULL;
-		alloc_table[alloc_ix].aligned = NULL;
+	/* initialize allocation table; no pages yet */
+	for (ix=0; ix < MAX_ALLOC_PAGES; ix++) {
+		alloc_table[ix] = NULL;
 	}
-	alloc_ix = 0;
+	free_head = -1;
+	num_used = 0;
 	num_alloc = 0;
 
+	/* initialize size classes */
+	cls = 0;
+	for (ix=0; ix <= MAX_CLASS_SIZE/16; ix++) {
+		while (class_size[cls] < ix*16) cls++;
+		class_of[ix] = cls;
+	}
+	for (cls=0; cls <= NUM_SIZE_CLASSES; cls++) {
+		if (cls < NUM_SIZE_CLASSES) {
+			class_state[cls].free_list = NULL;
+			class_state[cls].fresh = NULL;
+			class_state[cls].fresh_left = 0;
+			class_stats[cls].block_size = class_size[cls];
+		}
+		else class_stats[cls].block_size = 0;
+		class_stats[cls].in_use = 0;
+		class_stats[cls].high_water = 0;
+		class_stats[cls].allocs = 0;
+		class_stats[cls].frees = 0;
+		class_stats[cls].chunks = 0;
+	}
+
 	/* if we have reached Module R3, enable system call handling */
 	if (modules >= MODULE_R3) sysc_hand = TRUE;
 
@@ -192,7 +308,15 @@ int sys_init (    int      modules  /* module code */
 	}
 
 	/* get system date */
+#ifdef __TURBOC__
         getdate(&sys_date);
+#else
+	now = time(NULL);
+	now_tm = localtime(&now);
+	sys_date.da_year = now_tm->tm_year + 1900;
+	sys_date.da_mon = now_tm->tm_mon + 1;
+	sys_date.da_day = now_tm->tm_mday;
+#endif
 
 	return (OK);
 }
@@ -213,6 +337,7 @@ int sys_init (    int      modules  /* module code */
 void sys_exit(void)
 
 {
+#ifdef __TURBOC__
 	longword *vec_p;
 
 	/* if trap vector changed, restore it */
@@ -220,6 +345,7 @@ void sys_exit(void)
 		vec_p = (longword*) VEC_ADDR;
 		*vec_p = vec_save;
 	}
+#endif
 
 	/* return to host with null error code */
 	exit(0);
@@ -245,11 +371,16 @@ int sys_set_vec   ( void interrupt (*handler)() /* system call handler */
 		)
 
 {
+#ifdef __TURBOC__
 	longword *vec_p;
 	
 		vec_p = (longword*) VEC_ADDR;
 		vec_save = *vec_p;
 		*vec_p = (longword) handler;
+#else
+	/* no trap vectors on the host; sys_req calls the handler */
+	sysc_vec = handler;
+#endif
 
 	return (0);
 }
@@ -295,7 +426,8 @@ int sys_set_vec   ( void interrupt (*handler)() /* system call handler */
 	writing for several devices.
 
 	For Modules R1 through R4,
-	sys_req uses the ANSI C function "fgets."
+	sys_req uses the ANSI C functions "fgets" and "fwrite."
+	Terminal output is passed to fwrite as a single block.
 	Later modules may use alternate functions and device drivers.
 
 */
@@ -309,10 +441,10 @@ int sys_req (   int      op_code, /* operation code */
 {
 	int      rval;    /* result or error code */
 	char     *rp;     /* return pointer for fgets */
-	char     rc;      /* return char for fputc */
+#ifdef __TURBOC__
         params    *param_p; /* pointer to parameter record in stack */
+#endif
 	flag     docall;  /* true if system call interrupt wanted */
-	int      ix;      /* temporary index */
 
 
 	docall = FALSE;
@@ -353,13 +485,12 @@ int sys_req (   int      op_code, /* operation code */
 		case TERMINAL:
 			if (trm_hand) docall = TRUE;
 			else {
+				/* hand the whole buffer over at once */
 				rval = *count_p;
-				for (ix=0; ix<*count_p; ix++) {
-					rc = fputc(buf_p[ix],stdout);
-					if (rc == EOF) {
+				if (*count_p > 0) {
+					if (fwrite(buf_p, 1, (size_t) *count_p,
+						stdout) != (size_t) *count_p)
 						rval = ERR_SUP_WRFAIL;
-						break;
-					}
 				}
 
 			}
@@ -386,7 +517,12 @@ int sys_req (   int      op_code, /* operation code */
 		if (device_id==TERMINAL) {
 			if (trm_hand) docall = TRUE;
 			else {
+#ifdef __TURBOC__
 			     clrscr();
+#else
+				/* ANSI terminal: clear, cursor home */
+				fputs("\033[2J\033[H", stdout);
+#endif
 				rval = 0;
 			}
 		}
@@ -405,8 +541,14 @@ int sys_req (   int      op_code, /* operation code */
 					|| (*(buf_p+1) > MAX_YPOS))
 					rval = ERR_SUP_WRFAIL;
 				else {
+#ifdef __TURBOC__
 					gotoxy(*buf_p + 1,
 						*(buf_p+1) + 1);
+#else
+					printf("\033[%d;%dH",
+						*(buf_p+1) + 1,
+						*buf_p + 1);
+#endif
 					rval = 0;
 				}
 			}
@@ -433,6 +575,7 @@ int sys_req (   int      op_code, /* operation code */
 	*/
 	if (docall && (rval==OK)) {
 
+#ifdef __TURBOC__
 		/* invoke the call handler */
 	_SP = _SP - sizeof(params);
 		param_p = (params*) MK_FP(_SS,_SP);
@@ -443,6 +586,12 @@ int sys_req (   int      op_code, /* operation code */
 	       geninterrupt(0x60);
 	       rval = _AX;
 	       _SP = _SP + sizeof(params);
+#else
+		/* on the host, there is no INT 60h: the handler is an
+		   ordinary function, and gets the parameters as arguments */
+		if (sysc_vec == NULL) return(ERR_SUP_INVHAN);
+		(*sysc_vec)(op_code, device_id, buf_p, count_p);
+#endif
 
 		/* for I/O operations, return count value */
 		switch(op_code) {
@@ -465,28 +614,116 @@ int sys_req (   int      op_code, /* operation code */
 
 
 /*
+	Procedure: sys_writev
 
-	Procedure: sys_alloc_mem
+	Purpose: Write several buffers to a device, in order
 
-	Purpose: Allocate a memory block
+	Inputs:
+
+		device_id         device identifier
+		iov               array of buffer descriptors
+		iov_count         no. of entries in iov
+
+	Returns: Total no. of bytes written, or error code
+
+	Calls:   fwrite
+		sys_req
+
+	Globals: trm_hand
+
+	Errors:  ERR_SUP_INVDEV    invalid device
+		ERR_SUP_WRFAIL    write failed
+
+	Description:
+
+	This is a "gather" write: the effect is the same as one
+	WRITE request per buffer, but a table built from several
+	pieces can be sent to the terminal in one call.  Without
+	a terminal handler, all of the buffers are given to fwrite
+	back to back, so they reach the host together when the
+	output stream is flushed.  Otherwise, and for other devices,
+	each buffer is written with sys_req.  mpx_write uses it
+	to send the buffered terminal output and a long piece of
+	text together, without copying the text.
+
+	Stops at the first error, and returns that error code.
+
+*/
+
+int sys_writev (	int      device_id,        /* device id */
+			io_vec   iov[],            /* buffer descriptors */
+			int      iov_count         /* no. of descriptors */
+		)
+
+{
+	int      rval;    /* result or error code */
+	int      total;   /* total count written */
+	int      ix;      /* temporary index */
+
+	total = 0;
+	for (ix=0; ix<iov_count; ix++) {
+		if (iov[ix].count <= 0) continue;
+
+		if ((device_id == TERMINAL) && !trm_hand) {
+			if (fwrite(iov[ix].buf_p, 1, (size_t) iov[ix].count,
+				stdout) != (size_t) iov[ix].count)
+				return(ERR_SUP_WRFAIL);
+			rval = iov[ix].count;
+		}
+		else {
+			rval = sys_req(WRITE, device_id,
+				iov[ix].buf_p, &iov[ix].count);
+			if (rval < 0) return(rval);
+		}
+		total += rval;
+	}
+
+	return(total);
+}
+
+
+/*
+
+	Procedure: alloc_block
+
+	Purpose: Allocate a memory block (common code)
 
 	Parameters:
 	
 		size_t size       No. of bytes to allocate
+		flag zero         TRUE to clear the block
 
 	Returns: void* pointer to allocated block;
 		 null pointer in case of error
 		 
-	Calls: calloc
+	Calls: malloc, calloc, memset
 	
-	Globals: alloc_table, alloc_ix, num_alloc
+	Globals: alloc_table, free_head, num_used, num_alloc
+		 class_of, class_state, class_stats
 
 
 	For program loading (Module R-4), the blocks must be aligned.
-	This is achieved by requesting one extra paragraph and
-	returning the lowest aligned address as the base.  It is
-	necessary to keep a table of allocated address, original and
-	aligned, to support correct freeing.
+	Every block is preceded by an HDR_SIZE header and starts on
+	a paragraph boundary.
+
+	Blocks of up to MAX_CLASS_SIZE bytes are rounded up to a size
+	class and carved from CHUNK_SIZE chunks, which are aligned
+	once when obtained from malloc.  Freed blocks go on a free
+	list for their class and are re-used before any new chunk is
+	carved.  Chunks are never returned to the host.  Larger
+	blocks get their own calloc'd (or malloc'd) region, requested
+	with 15 extra bytes so it can be aligned.
+
+	A table of allocated blocks (with the original address of
+	large blocks) supports correct freeing and the detection of
+	bad pointers.  Each block's header gives its index in the
+	table; free table entries are kept on a list.  Neither
+	allocating nor freeing ever has to search the table.
+
+	The table is a directory of pages of ALLOC_PAGE_SIZE entries.
+	A page is added only when every existing entry is in use, and
+	existing pages never move, so the number of live blocks is
+	limited only by MAX_ALLOC_PAGES and the heap itself.
 
 	It would seem simpler to use the Turbo-C function allocmem,
 	which always allocates aligned blocks.  However, allocmem
@@ -496,54 +733,177 @@ int sys_req (   int      op_code, /* operation code */
 
 */
 
-void *sys_alloc_mem (      size_t   size     /* size in bytes to allocate */
-		    )
+static void *alloc_block ( size_t size, flag zero )
 {
-	int ix_save;      /* temp copy of table index */
-        void *addr;        /* addr returned by calloc (*void) */
+	long ix;          /* table index for the new block */
+        void *addr;        /* addr returned by malloc/calloc (*void) */
+#ifdef __TURBOC__
 	word offset;      /* offset of unaligned address */
 	word seg;         /* segment addr of unaligned address */
-	void *addr_alig; /* aligned address */
 	int rem; /* temp for alignment computation */
+#endif
+	void *addr_alig; /* aligned address */
+	int cls;          /* size class of the block */
+	byte *blk;        /* start of block, including header */
 
-	/* ensure that allocation table is not full */
-	if (num_alloc >= MAX_ALLOC) {
-		return(NULL);
+	/* take a free table entry, or the next never-used one */
+	if (free_head >= 0) {
+		ix = free_head;
 	}
-
-	/* find free entry in allocation table */
-	ix_save = alloc_ix;
-	while (alloc_table[alloc_ix].original != NULL) {
-		alloc_ix++;
-		if (alloc_ix >= MAX_ALLOC) alloc_ix = 0;
-
-		/* safety check -- should never happen! */
-		if (alloc_ix == ix_save) return(NULL);
+	else {
+		/* ensure that allocation table is not full */
+		if (num_used >= (long) MAX_ALLOC_PAGES * ALLOC_PAGE_SIZE) {
+			return(NULL);
+		}
+		ix = num_used;
+
+		/* starting a new page: allocate it */
+		if (alloc_table[ix >> ALLOC_PAGE_SHIFT] == NULL) {
+			alloc_table[ix >> ALLOC_PAGE_SHIFT] = (alloc_entry*)
+				malloc(ALLOC_PAGE_SIZE * sizeof(alloc_entry));
+			if (alloc_table[ix >> ALLOC_PAGE_SHIFT] == NULL)
+				return(NULL);
+		}
 	}
 
-	/* call allocation routine */
-	/* request 15 extra bytes to ensure alignment is possible */
-	addr = calloc(size + 15,1);
+	if (size <= MAX_CLASS_SIZE) {
 
-	/* compute aligned base */
-	offset = FP_OFF(addr);
-        seg = FP_SEG(addr);
-	rem = offset % 16;
-	if (rem > 0) offset = offset + 16 - rem;
-	addr_alig = MK_FP(seg,offset);
+		/* small block: take one from its size class */
+		cls = class_of[(size + 15) / 16];
+		addr = NULL;
 
-	/* insert entries in table */
-	alloc_table[alloc_ix].original = addr;
-	alloc_table[alloc_ix].aligned = addr_alig;
+		if (class_state[cls].free_list != NULL) {
+			blk = class_state[cls].free_list;
+			class_state[cls].free_list =
+				*(byte**) (blk + HDR_SIZE);
+		}
+		else {
+			/* no never-used slots left: get a new chunk */
+			if (class_state[cls].fresh_left == 0) {
+				addr = malloc(CHUNK_SIZE + 15);
+				if (addr == NULL) return(NULL);
+
+				/* compute aligned base */
+#ifdef __TURBOC__
+				offset = FP_OFF(addr);
+			        seg = FP_SEG(addr);
+				rem = offset % 16;
+				if (rem > 0) offset = offset + 16 - rem;
+				class_state[cls].fresh = MK_FP(seg,offset);
+#else
+				class_state[cls].fresh = (byte*)
+					(((size_t) addr + 15) & ~(size_t) 15);
+#endif
+				class_state[cls].fresh_left = CHUNK_SIZE /
+					(HDR_SIZE + class_size[cls]);
+				class_stats[cls].chunks++;
+				addr = NULL;
+			}
+			blk = class_state[cls].fresh;
+			class_state[cls].fresh += HDR_SIZE + class_size[cls];
+			class_state[cls].fresh_left--;
+		}
+		addr_alig = blk + HDR_SIZE;
+		if (zero) memset(addr_alig, 0, size);
+	}
+	else {
+
+		/* large block: call allocation routine */
+		/* request room for the header, plus 15 extra bytes
+		   to ensure alignment is possible */
+		cls = NUM_SIZE_CLASSES;
+		if (zero) addr = calloc(size + HDR_SIZE + 15,1);
+		else addr = malloc(size + HDR_SIZE + 15);
+		if (addr == NULL) return(NULL);
+
+		/* compute aligned base, leaving room for the header */
+#ifdef __TURBOC__
+		offset = FP_OFF(addr) + HDR_SIZE;
+	        seg = FP_SEG(addr);
+		rem = offset % 16;
+		if (rem > 0) offset = offset + 16 - rem;
+		addr_alig = MK_FP(seg,offset);
+#else
+		addr_alig = (void*)
+			(((size_t) addr + HDR_SIZE + 15) & ~(size_t) 15);
+#endif
+	}
 
+	/* claim the table entry and fill it in */
+	if (ix == free_head) free_head = ALLOC_ENTRY(ix).next_free;
+	else num_used++;
+	ALLOC_ENTRY(ix).original = addr;
+	ALLOC_ENTRY(ix).aligned = addr_alig;
+	BLOCK_HDR(addr_alig)->ix = ix;
+	BLOCK_HDR(addr_alig)->cls = cls;
 
-	/* increment count */
+
+	/* increment counts */
 	num_alloc++;
+	class_stats[cls].allocs++;
+	class_stats[cls].in_use++;
+	if (class_stats[cls].in_use > class_stats[cls].high_water)
+		class_stats[cls].high_water = class_stats[cls].in_use;
 
 	return(addr_alig);
 
 }
-
+
+/*
+
+	Procedure: sys_alloc_mem
+
+	Purpose: Allocate a memory block, cleared to zero
+
+	Parameters:
+	
+		size_t size       No. of bytes to allocate
+
+	Returns: void* pointer to allocated block;
+		 null pointer in case of error
+		 
+	Calls: alloc_block
+	
+	Globals: none (see alloc_block)
+
+*/
+
+void *sys_alloc_mem (      size_t   size     /* size in bytes to allocate */
+		    )
+{
+	return(alloc_block(size, TRUE));
+}
+
+/*
+
+	Procedure: sys_alloc_mem_nz
+
+	Purpose: Allocate a memory block, without clearing it
+
+	Parameters:
+	
+		size_t size       No. of bytes to allocate
+
+	Returns: void* pointer to allocated block;
+		 null pointer in case of error
+		 
+	Calls: alloc_block
+	
+	Globals: none (see alloc_block)
+
+
+	Identical to sys_alloc_mem, except that the contents of the
+	block are undefined.  Use this when the caller is about to
+	overwrite the whole block anyway.
+
+*/
+
+void *sys_alloc_mem_nz (   size_t   size     /* size in bytes to allocate */
+		    )
+{
+	return(alloc_block(size, FALSE));
+}
+
 /*
 
 	Procedure: sys_free_mem
@@ -558,13 +918,17 @@ void *sys_alloc_mem (      size_t   size     /* size in bytes to allocate */
 	
 	Calls:   free
 
-	Globals: alloc_table, num_alloc
+	Globals: alloc_table, free_head, num_alloc
+		 class_state, class_stats
 
 	Errors:  ERR_SUP_INVMEM    invalid memory block
 
 
-	This procedure receives an aligned address; it must
-	find and free the corresponding non-aligned one.
+	This procedure receives an aligned address.  The block
+	header names the table entry; the entry is then checked,
+	so a bad pointer is still reported.  Small blocks go back
+	on the free list of their size class; for large blocks,
+	the corresponding non-aligned address is freed.
 
 */
 
@@ -572,36 +936,81 @@ int sys_free_mem (         void     *ptr     /* pointer to block */
 		 )
 {
 	void *free_addr;  /* true (unaligned) block address */
-	int free_ix;               /* temp table index */
+	long free_ix;              /* table index from block header */
+	int cls;                   /* size class from block header */
 
 	/* ensure valid pointer */
 	if (ptr==NULL) return(ERR_SUP_INVMEM);
 
-	/* Look for the block in the allocation table */
-	free_addr = NULL;
-	for (free_ix=0; free_ix<MAX_ALLOC; free_ix++) {
-		if (alloc_table[free_ix].aligned == ptr) {
-			free_addr = alloc_table[free_ix].original;
-			break;
-		}
-	}
+	/* Look up the block's entry in the allocation table */
+	free_ix = BLOCK_HDR(ptr)->ix;
+	if ((free_ix < 0) || (free_ix >= num_used)) return(ERR_SUP_INVMEM);
 
-	/* If the block wasn't found, report error */
-	if (free_addr == NULL) return(ERR_SUP_INVMEM);
+	/* If the entry isn't for this block, report error */
+	if (ALLOC_ENTRY(free_ix).aligned != ptr) return(ERR_SUP_INVMEM);
+	free_addr = ALLOC_ENTRY(free_ix).original;
+	cls = BLOCK_HDR(ptr)->cls;
 
 
-	/* free the block & clear the table entry */
-	alloc_table[free_ix].original = NULL;
-	alloc_table[free_ix].aligned = NULL;
-        free(free_addr);
+	/* put the table entry on the free list */
+	ALLOC_ENTRY(free_ix).original = NULL;
+	ALLOC_ENTRY(free_ix).aligned = NULL;
+	ALLOC_ENTRY(free_ix).next_free = free_head;
+	free_head = free_ix;
 
-	/* decrement count */
+	/* free the block */
+	if (cls < NUM_SIZE_CLASSES) {
+		*(byte**) ptr = class_state[cls].free_list;
+		class_state[cls].free_list = (byte*) ptr - HDR_SIZE;
+	}
+	else free(free_addr);
+
+	/* decrement counts */
 	num_alloc--;
+	class_stats[cls].frees++;
+	class_stats[cls].in_use--;
 
 	return(OK);
 
 }        
-
+
+/*
+
+	Procedure: sys_alloc_stats
+
+	Purpose: report memory allocation statistics
+
+	Parameters:
+
+		alloc_stats stats[]   array to receive statistics
+		int max_stats         no. of entries in stats[]
+
+	Returns: no. of entries filled in
+	
+	Calls:   none
+
+	Globals: class_stats
+
+
+	One entry is filled in for each size class, smallest first,
+	followed by one (with block_size 0) for large blocks, up to
+	a total of NUM_SIZE_CLASSES+1 entries.
+
+*/
+
+int sys_alloc_stats (      alloc_stats stats[], /* statistics array */
+			int      max_stats  /* size of array */
+		 )
+{
+	int cls;                   /* size class index */
+
+	for (cls=0; cls <= NUM_SIZE_CLASSES && cls < max_stats; cls++) {
+		stats[cls] = class_stats[cls];
+	}
+
+	return(cls);
+}
+
 /*
 
 	Procedure: sys_get_date
@@ -686,6 +1095,7 @@ int sys_set_date (  date_rec*       date_p   /* ptr to date record */
 int sys_open_dir (  char  path_name[]        /* directory name */
 		 )
 {
+#ifdef __TURBOC__
         char temp_path[MAX_PATH_SIZE];
 	int res;
         int len;
@@ -729,6 +1139,10 @@ int sys_open_dir (  char  path_name[]        /* directory name */
 	num_entries = 0;
 
 	return(OK);
+#else
+	/* the host build has no DOS directory search */
+	return(ERR_SUP_INVDIR);
+#endif
 }
 
 /*
@@ -759,6 +1173,7 @@ int sys_get_entry (char    name_buf[],       /* buffer for entry */
 
 
 {
+#ifdef __TURBOC__
 	char filename[MAX_PATH_SIZE+1];
 	int err;
         int len;
@@ -802,6 +1217,9 @@ int sys_get_entry (char    name_buf[],       /* buffer for entry */
 	num_entries++;
 
 	return(OK);
+#else
+	return(ERR_SUP_NOENTR);
+#endif
 }
 
 /*
@@ -948,6 +1366,7 @@ int sys_load_program (     void*    load_addr,        /* address for loading */
 			char     prog_name[]       /* program name */
 		      )
 {
+#ifdef __TURBOC__
 
 	int errcode;      /* error code */
         int prog_len;      /* program length */
@@ -1025,6 +1444,10 @@ int sys_load_program (     void*    load_addr,        /* address for loading */
 	/* load successful */
 	return(OK);
 
+#else
+	/* the host build has no MS-DOS loader */
+	return(ERR_SUP_LDFAIL);
+#endif
 }
 
 /* END OF FILE */
@@ -37,6 +37,9 @@
 			changed sys_req params
 	01/03/93  jdm	revised error codes and names
 	02/24/93  jdm	changed sys_set_vec param to interrupt
+	10/16/26  pp	added sys_alloc_mem_nz, sys_alloc_stats
+	10/16/26  pp	added sys_writev
+	10/16/26  pp	interrupt keyword dropped on the host
 
 ************************************************************************/
 #ifndef MPX_SUPT
@@ -54,6 +57,12 @@
 
 #define	NULCH	('\0')
 
+/* Turbo C's interrupt functions; on the host (any other compiler),
+   a system call handler is an ordinary function */
+#ifndef __TURBOC__
+#define interrupt
+#endif
+
 /* status and error codes */
 #define OK	0
 #define ERR_SUP_INVDEV (-101) /* invalid device id */
@@ -120,6 +129,24 @@
 
 typedef int flag;
 
+/* Buffer descriptor for gather writes (sys_writev) */
+typedef struct {
+	char *buf_p;		/* data buffer */
+	int count;		/* no. of bytes in buffer */
+	} io_vec;
+
+/* Memory allocation statistics for one size class */
+#define NUM_SIZE_CLASSES	14
+
+typedef struct {
+	size_t block_size;	/* class block size; 0 for large blocks */
+	long in_use;		/* no. of blocks now allocated */
+	long high_water;	/* largest no. ever allocated at once */
+	long allocs;		/* total no. of allocations */
+	long frees;		/* total no. of frees */
+	long chunks;		/* no. of chunks obtained from the heap */
+	} alloc_stats;
+
 /* Date record */
 typedef struct {
 	int month;
@@ -152,16 +179,34 @@ typedef struct {
 			int *count_p	/* ptr to transfer count */
 		      );
 
+	/* sys_writev: write several buffers to a device */
+	/*	RETURNS: total count written, or error code */
+	int sys_writev ( int device_id,	/* device identifier */
+			io_vec iov[],	/* buffer descriptors */
+			int iov_count	/* no. of descriptors */
+		      );
+
 	/* sys_alloc_mem: allocate memory */
 	/* RETURNS: pointer to allocated block */
 	void *sys_alloc_mem ( size_t size /* block size */
 		      );
 		      
+	/* sys_alloc_mem_nz: allocate memory, without clearing it */
+	/* RETURNS: pointer to allocated block */
+	void *sys_alloc_mem_nz ( size_t size /* block size */
+		      );
+		      
 	/* sys_free_mem: free memory */
 	/* RETURNS: integer error code, or 0 if ok */
 	int sys_free_mem (	void *ptr /* ptr to memory to free */
 			);
 		      
+	/* sys_alloc_stats: get memory allocation statistics */
+	/* RETURNS: number of entries filled in */
+	int sys_alloc_stats (	alloc_stats stats[], /* statistics array */
+				int max_stats /* size of array */
+			);
+		      
 	/* sys_get_date: get system date */
 	void sys_get_date ( date_rec *date_p /* date record */
 		      );
@@ -26,6 +26,7 @@
 #include "mpx_util.h"
 #include "mpx_supt.h"
 #include "pager.h"
+#include "mpx_out.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -138,5 +139,7 @@ int mpx_cat ( char *file_name ){
 
 
 void mpx_cls (void) {
+	/* Anything still buffered belongs on the old screen. */
+	mpx_flush();
 	sys_req(CLEAR, TERMINAL, NULL, 0);
 }
@@ -23,6 +23,7 @@
 #include "pager.h"
 #include "mpx_supt.h"
 #include "mpx_util.h"
+#include "mpx_out.h"
 #include <stdio.h>
 #include <stdarg.h>
 
@@ -35,32 +36,50 @@ void end_of_page_prompt (void)
 	int buf_size=4;
 	int retval;
 
-	printf("<<_ PRESS [ RETURN ] for more output _>>");
+	mpx_printf("<<_ PRESS [ RETURN ] for more output _>>");
+	mpx_flush();
 
 	retval = sys_req( READ, TERMINAL, buf, &buf_size );
 	if ( retval < 0 ) {
-		printf("ERROR: sys_req() threw error while trying to read ");
-		printf("from the terminal!\n");
+		mpx_printf("ERROR: sys_req() threw error while trying to read ");
+		mpx_printf("from the terminal!\n");
 		return;
 	}
 
 	mpx_cls();
 }
 
-/*! Keeps track of how many rows have been printed on the current screen.
+/*! The value of mpx_out_lines() at the top of the current screen.
+ *
+ * The number of rows printed on the current screen is the number of newlines
+ * output since then, whichever function output them.
  *
  * Note that this is a file-static variable, and thus is only accessible
  * inside the \c pager.c file.
  */
-static rows_printed = 0;
+static unsigned long page_start_line = 0;
+
+/*! Non-zero if the pager should stop at the end of each screenful.
+ *
+ * This is turned off in batch mode, where nobody is there to press RETURN.
+ */
+static int pager_interactive = 1;
+
+
+/*! Turns the end-of-page prompts on (non-zero) or off (zero).
+ */
+void pager_set_interactive (int interactive)
+{
+	pager_interactive = interactive;
+}
 
 
 /*! This function is called before the first line of paged output is printed.
  */
 void pager_init (void)
 {
-	/* Reset the rows_printed accumulator to begin a paged output afresh. */
-	rows_printed = 0;
+	/* Start counting rows afresh to begin a paged output. */
+	page_start_line = mpx_out_lines();
 }
 
 
@@ -73,15 +92,13 @@ void pager_stop (void)
 }
 
 
-/*! This function replaces \c printf() when paged output is desired.
+/*! This function replaces \c mpx_printf() when paged output is desired.
  *
- * Use only this function for output to the screen between calls to
- * \c pager_init() and \c pager_stop(). Writing to the terminal with any
- * other routine/method while paging will cause the output to be garbled,
- * or lines to be missed.
- *
- * This function makes use of two ANSI-standard C features: variable-length
- * argument lists (va_list), and vprintf.
+ * Rows are counted by the newlines in the output, so text may be output with
+ * mpx_printf() too while paging; but the end-of-page prompt is only shown
+ * from here, and text with several newlines may run past the end of the
+ * page before it is.  Writing to the terminal other than through the
+ * \c mpx_out module while paging will cause the output to be garbled.
  *
  * @return
  * 	Returns the number of bytes output to the screen,
@@ -94,16 +111,15 @@ int pager_printf (const char *format, ...)
 	va_list args;
 	va_start(args, format);
 
-	/* Pass the format string and the rest of the args onto vprintf. */
-	bytes_written = vprintf(format, args);
+	/* Pass the format string and the rest of the args onto mpx_vprintf. */
+	bytes_written = mpx_vprintf(format, args);
 
 	va_end(args);
 
-	rows_printed++;
-
-	if ( (rows_printed % (SCREEN_ROWS-1)) == 0 ){
-		rows_printed = 0;
+	if ( pager_interactive &&
+	     mpx_out_lines() - page_start_line >= SCREEN_ROWS-1 ){
 		end_of_page_prompt();
+		page_start_line = mpx_out_lines();
 	}
 
 	return bytes_written;
@@ -1,5 +1,5 @@
-#ifndef PCB_H_GUARD
-#define PCB_H_GUARD
+#ifndef PAGER_H_GUARD
+#define PAGER_H_GUARD
 
 
 /*!
@@ -27,6 +27,7 @@
 
 void pager_init (void);
 void pager_stop (void);
+void pager_set_interactive (int interactive);
 int pager_printf (const char *format, ...);
 
 
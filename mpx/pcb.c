@@ -16,6 +16,34 @@ static	pcb_queue_t	queue_ready;
 static	pcb_queue_t	queue_blocked;
 static	pcb_queue_t	queue_susp_ready;
 static	pcb_queue_t	queue_susp_blocked;
+static	pcb_queue_t	queue_realtime;
+
+static	pcb_priority_index_t	prio_index_ready;
+static	pcb_priority_index_t	prio_index_susp_ready;
+
+/* The scheduling policy in charge of the ready queue. */
+static	sched_policy_t	*sched_policy;
+
+/* The policy in charge of a POLICY queue: sched_edf for the real-time
+ * queue, and sched_policy for the ready queue. */
+#define QUEUE_POLICY(queue) \
+	( (queue) == &queue_realtime ? &sched_edf : sched_policy )
+
+/* The scheduling clock; see get_sched_clock().  The PCB that was last
+ * dispatched (see dequeue_ready_pcb()), and the clock when it was, so that
+ * block_pcb() can tell how long it ran. */
+static	unsigned long	sched_clock;
+static	pcb_t		*dispatched_pcb;
+static	unsigned long	dispatched_at;
+
+/* Process groups (see get_group()), and the clock ticks they have run
+ * since their recent_ticks were last halved. */
+static	pcb_group_t	groups[PCB_MAX_GROUPS];
+static	unsigned int	group_share_clock;
+
+/* lowest_set_bit[b] is the index of the least-significant 1 bit in b
+ * (find-first-set on a byte); filled in by init_pcb_queues(). */
+static	unsigned char	lowest_set_bit[256];
 
 
 /*! Extern variable that allows other files to directly access PCB queues.
@@ -23,35 +51,410 @@ static	pcb_queue_t	queue_susp_blocked;
  * @todo  We really need to replace this with some various
  * get_queue() type functions!
  */
-pcb_queue_t	*queues[4];
+pcb_queue_t	*queues[5];
+
+
+/* PCB pool: PCBs are carved from chunks of PCB_POOL_CHUNK_SLOTS.  Each
+ * chunk holds all of its PCBs side by side, then their scheduling and cold
+ * parts, then their stacks, so that the PCBs themselves are densely
+ * packed. */
+typedef struct pcb_chunk {
+	pcb_t		pcb[PCB_POOL_CHUNK_SLOTS];
+	pcb_sched_t	sched[PCB_POOL_CHUNK_SLOTS];
+	pcb_cold_t	cold[PCB_POOL_CHUNK_SLOTS];
+	unsigned char	stack[PCB_POOL_CHUNK_SLOTS][STACK_SIZE];
+} pcb_chunk_t;
+
+/* PCB pool: PCBs released by free_pcb(), chained through queue_node.pcb
+ * (every PCB here has a zeroed stack), the most recent chunk and how many
+ * of its PCBs have been handed out, and the statistics reported by
+ * get_pcb_pool_stats(). */
+static	pcb_t		*pool_free_list	= NULL;
+static	pcb_chunk_t	*pool_fresh	= NULL;
+static	unsigned int	pool_fresh_used	= PCB_POOL_CHUNK_SLOTS;
+static	pcb_pool_stats_t	pool_stats	= { 0, 0, 0, 0 };
+
+/* Handle table: every chunk of the PCB pool, in the order they were
+ * allocated, so that slot n is PCB n % PCB_POOL_CHUNK_SLOTS of chunk
+ * n / PCB_POOL_CHUNK_SLOTS.  The directory doubles as needed. */
+static	pcb_chunk_t	**pool_chunks		= NULL;
+static	unsigned long	pool_chunks_max		= 0;
+
+/* The parts of a pcb_handle_t (see PCB_HANDLE_INDEX_BITS). */
+#define HANDLE_INDEX_MASK	((1UL << PCB_HANDLE_INDEX_BITS) - 1)
+#define HANDLE_GEN_MASK		(0xFFFFFFFFUL >> PCB_HANDLE_INDEX_BITS)
+#define HANDLE_INDEX(h)		((h) & HANDLE_INDEX_MASK)
+#define HANDLE_GEN(h)		(((h) >> PCB_HANDLE_INDEX_BITS) & HANDLE_GEN_MASK)
+
+
+/* Process-name table: every process name in use, stored once, and
+ * referred to by PCBs through a pcb_name_id_t.  Entries live in pages of
+ * PCB_NAME_PAGE_SIZE, found through a directory that doubles as needed, so
+ * no single block gets large.  Unused entries are chained through next.
+ * Entry 0 is never used, so that an id of 0 can mean "no name". */
+typedef struct pcb_name {
+
+	/* The name itself. */
+	char		text[MAX_ARG_LEN+1];
+
+	/* Number of allocated PCBs with this name. */
+	unsigned int	refs;
+
+	/* Hash of the name. */
+	unsigned int	hash;
+
+	/* Next entry in the same bucket of the index (or on the free list). */
+	pcb_name_id_t	next;
+
+	/* The enqueued PCB with this name, or NULL if there is none. */
+	pcb_t		*pcb;
+
+} pcb_name_t;
+
+static	pcb_name_t	**name_pages	= NULL;
+static	unsigned int	name_pages_max	= 0;
+static	unsigned int	name_pages_used	= 0;
+static	pcb_name_id_t	name_free_list	= 0;
+static	unsigned long	name_count	= 0;
+
+/* The entry for a (non-zero) pcb_name_id_t. */
+#define NAME_ENTRY(id) \
+	(&name_pages[(id) / PCB_NAME_PAGE_SIZE][(id) % PCB_NAME_PAGE_SIZE])
+
+/* Process-name index: a chained hash table of the process-name table, so
+ * that names can be interned and find_pcb() need not search the queues.
+ * It starts out in static storage and is moved to the heap when it grows.
+ * name_index_count is the number of names whose entry has a PCB, i.e. the
+ * number of enqueued PCBs. */
+static	pcb_name_id_t	name_index_initial[PCB_INDEX_MIN_BUCKETS];
+static	pcb_name_id_t	*name_index		= name_index_initial;
+static	unsigned int	name_index_size	= PCB_INDEX_MIN_BUCKETS;
+static	unsigned long	name_index_count = 0;
+
+
+/*! Computes the hash of a process name (djb2).
+ *
+ * @private
+ */
+static unsigned int hash_process_name( char *name )
+{
+	unsigned int hash = 5381;
+
+	while ( *name != '\0' ) {
+		hash = ((hash << 5) + hash) + (unsigned char)*name++;
+	}
+
+	return hash;
+}
+
+
+/*! Finds a name in the process-name table.
+ *
+ * @return	Returns the name's id, or 0 if it is not in the table.
+ *
+ * @private
+ */
+static pcb_name_id_t name_lookup( char *name, unsigned int hash )
+{
+	pcb_name_id_t	 id = name_index[ hash & (name_index_size-1) ];
+	pcb_name_t	*entry;
+
+	while ( id != 0 ) {
+		entry = NAME_ENTRY(id);
+		if ( entry->hash == hash && strcmp( entry->text, name ) == 0 ) {
+			return id;
+		}
+		id = entry->next;
+	}
+
+	return 0;
+}
+
+
+/*! Gets an unused entry from the process-name table, adding a page to the
+ *  table if there are none.
+ *
+ * @return	Returns the entry's id, or 0 if memory is exhausted.
+ *
+ * @private
+ */
+static pcb_name_id_t name_alloc( void )
+{
+	pcb_name_t	**new_pages;
+	unsigned int	new_max;
+	pcb_name_id_t	id;
+	unsigned int	i;
+
+	if ( name_free_list == 0 ) {
+		/* Ids must stay representable. */
+		if ( name_pages_used >=
+				((pcb_name_id_t)-1) / PCB_NAME_PAGE_SIZE ) {
+			return 0;
+		}
+
+		/* Make room in the directory, doubling it if needed. */
+		if ( name_pages_used == name_pages_max ) {
+			new_max = name_pages_max ? 2*name_pages_max : 16;
+			new_pages = (pcb_name_t **)sys_alloc_mem_nz(
+				new_max * sizeof(pcb_name_t *) );
+			if ( new_pages == NULL ) {
+				return 0;
+			}
+			if ( name_pages != NULL ) {
+				memcpy( new_pages, name_pages,
+					name_pages_used * sizeof(pcb_name_t *) );
+				sys_free_mem( name_pages );
+			}
+			name_pages	= new_pages;
+			name_pages_max	= new_max;
+		}
+
+		name_pages[name_pages_used] = (pcb_name_t *)sys_alloc_mem_nz(
+			PCB_NAME_PAGE_SIZE * sizeof(pcb_name_t) );
+		if ( name_pages[name_pages_used] == NULL ) {
+			return 0;
+		}
+		name_pages_used++;
+
+		/* Put the new entries on the free list, lowest id first (and
+		 * skipping id 0). */
+		for ( i = PCB_NAME_PAGE_SIZE; i > 0; i-- ) {
+			id = (name_pages_used-1) * PCB_NAME_PAGE_SIZE + (i-1);
+			if ( id != 0 ) {
+				NAME_ENTRY(id)->next = name_free_list;
+				name_free_list = id;
+			}
+		}
+	}
+
+	id = name_free_list;
+	name_free_list = NAME_ENTRY(id)->next;
+	return id;
+}
+
+
+/*! Doubles the number of buckets in the process-name index.
+ *
+ * If the larger bucket array cannot be allocated, the index simply stays
+ * at its current size; lookups remain correct, only the chains get longer.
+ *
+ * @private
+ */
+static void name_index_grow( void )
+{
+	pcb_name_id_t	*new_index;
+	unsigned int	new_size = name_index_size * 2;
+	pcb_name_id_t	this_id;
+	pcb_name_id_t	next_id;
+	pcb_name_t	*entry;
+	unsigned int	i;
+
+	new_index = (pcb_name_id_t *)sys_alloc_mem(
+		new_size * sizeof(pcb_name_id_t) );
+	if ( new_index == NULL ) {
+		return;
+	}
+
+	/* sys_alloc_mem() hands back zeroed memory, so every bucket is
+	 * already empty; re-link each name into its new bucket. */
+	for ( i = 0; i < name_index_size; i++ ) {
+		this_id = name_index[i];
+		while ( this_id != 0 ) {
+			entry = NAME_ENTRY(this_id);
+			next_id = entry->next;
+			entry->next = new_index[ entry->hash & (new_size-1) ];
+			new_index[ entry->hash & (new_size-1) ] = this_id;
+			this_id = next_id;
+		}
+	}
+
+	if ( name_index != name_index_initial ) {
+		sys_free_mem( name_index );
+	}
+	name_index	= new_index;
+	name_index_size	= new_size;
+}
+
+
+/*! Interns a process name: returns the id of its entry in the process-name
+ *  table, adding one if need be, and counts one more reference to it.
+ *
+ * @return	Returns the id, or 0 if memory is exhausted.
+ *
+ * @private
+ */
+static pcb_name_id_t intern_name( char *name )
+{
+	unsigned int	 hash = hash_process_name( name );
+	pcb_name_id_t	 id = name_lookup( name, hash );
+	pcb_name_t	*entry;
+	pcb_name_id_t	*bucket;
+
+	if ( id != 0 ) {
+		NAME_ENTRY(id)->refs++;
+		return id;
+	}
+
+	if ( name_count >=
+			(unsigned long)name_index_size * PCB_INDEX_MAX_LOAD &&
+			name_index_size < PCB_INDEX_MAX_BUCKETS ) {
+		name_index_grow();
+	}
+
+	id = name_alloc();
+	if ( id == 0 ) {
+		return 0;
+	}
+
+	entry = NAME_ENTRY(id);
+	strcpy( entry->text, name );
+	entry->refs	= 1;
+	entry->hash	= hash;
+	entry->pcb	= NULL;
+
+	bucket = &name_index[ hash & (name_index_size-1) ];
+	entry->next = *bucket;
+	*bucket = id;
+	name_count++;
+
+	return id;
+}
+
+
+/*! Drops one reference to an interned name, removing it from the table
+ *  once nothing refers to it.
+ *
+ * @private
+ */
+static void release_name( pcb_name_id_t id )
+{
+	pcb_name_t	*entry = NAME_ENTRY(id);
+	pcb_name_id_t	*link;
+
+	if ( --entry->refs > 0 ) {
+		return;
+	}
+
+	/* Find the link that points at this entry, and bypass it. */
+	link = &name_index[ entry->hash & (name_index_size-1) ];
+	while ( *link != id ) {
+		link = &NAME_ENTRY(*link)->next;
+	}
+	*link = entry->next;
+
+	entry->next = name_free_list;
+	name_free_list = id;
+	name_count--;
+}
+
+
+/*! Empties a priority-level index.
+ *
+ * @private
+ */
+static void init_priority_index( pcb_priority_index_t *index )
+{
+	/* Loop index. */
+	int i;
+
+	for ( i=0; i<PRIORITY_LEVELS; i++ ){
+		index->level_tail[i] = NULL;
+	}
+	for ( i=0; i<PRIORITY_LEVELS/8; i++ ){
+		index->level_map[i] = 0;
+	}
+}
+
+
+/*! Finds the closest non-empty priority level above the given one.
+ *
+ * Scans the occupancy bitmap a byte at a time, so the cost is bounded by
+ * PRIORITY_LEVELS/8 no matter how many PCBs are enqueued.
+ *
+ * @return	Returns the level number, or -1 if every higher level is empty.
+ *
+ * @private
+ */
+static int find_level_above( pcb_priority_index_t *index, int level )
+{
+	/* The bits of the current bitmap byte still worth looking at. */
+	unsigned char bits;
+
+	/* Loop index (over bytes of the bitmap). */
+	int i;
+
+	level++;
+	if ( level >= PRIORITY_LEVELS ){
+		return -1;
+	}
+
+	i = level / 8;
+	bits = index->level_map[i] & (unsigned char)(0xFF << (level % 8));
+	for (;;){
+		if ( bits != 0 ){
+			return i*8 + lowest_set_bit[bits];
+		}
+		if ( ++i >= PRIORITY_LEVELS/8 ){
+			return -1;
+		}
+		bits = index->level_map[i];
+	}
+}
 
 
 /*! Must be called before using any other PCB or queue functions. */
 void init_pcb_queues(void)
 {
+	/* Loop index. */
+	int i;
+
+	lowest_set_bit[0] = 0;
+	for ( i=1; i<256; i++ ){
+		lowest_set_bit[i] = (i & 1) ? 0 : lowest_set_bit[i >> 1] + 1;
+	}
+
+	init_priority_index( &prio_index_susp_ready );
+
+	/* Every process starts out in the default group. */
+	memset( groups, 0, sizeof(groups) );
+	strcpy( groups[0].name, "default" );
+	groups[0].weight = GROUP_WEIGHT_DEFAULT;
+
+	/* The ready queue's order is up to the scheduling policy. */
 	queues[0] = &queue_ready;
 	queue_ready.head		= NULL;
 	queue_ready.tail		= NULL;
 	queue_ready.length		= 0;
-	queue_ready.sort_order		= PRIORITY;
+	sched_policy = sched_policies[0];
+	sched_policy->start( &queue_ready );
 
 	queues[1] = &queue_blocked;
 	queue_blocked.head		= NULL;
 	queue_blocked.tail		= NULL;
 	queue_blocked.length		= 0;
 	queue_blocked.sort_order	= FIFO;
+	queue_blocked.prio_index	= NULL;
 
 	queues[2] = &queue_susp_ready;
 	queue_susp_ready.head		= NULL;
 	queue_susp_ready.tail		= NULL;
 	queue_susp_ready.length		= 0;
 	queue_susp_ready.sort_order	= PRIORITY;
+	queue_susp_ready.prio_index	= &prio_index_susp_ready;
 
 	queues[3] = &queue_susp_blocked;
 	queue_susp_blocked.head		= NULL;
 	queue_susp_blocked.tail		= NULL;
 	queue_susp_blocked.length	= 0;
 	queue_susp_blocked.sort_order	= FIFO;
+	queue_susp_blocked.prio_index	= NULL;
+
+	/* Ready real-time processes; always dispatched first. */
+	queues[4] = &queue_realtime;
+	queue_realtime.head		= NULL;
+	queue_realtime.tail		= NULL;
+	queue_realtime.length		= 0;
+	sched_edf.start( &queue_realtime );
 }
 
 
@@ -86,384 +489,1322 @@ pcb_queue_t* get_queue_by_state (
 }
 
 
+/*! References the queue of ready real-time processes (see
+ *  set_pcb_realtime()), which are kept apart from the other ready
+ *  processes, in the ready queue.
+ */
+pcb_queue_t* get_realtime_queue( void )
+{
+	return &queue_realtime;
+}
+
+
+/*! References the queue a PCB belongs in, given its state and class; a
+ *  throttled real-time process (see update_realtime()) is in the ready
+ *  queue.
+ *
+ * @return	Returns the queue, or NULL if the PCB's state is invalid.
+ *
+ * @private
+ */
+static pcb_queue_t* home_queue( pcb_t *pcb )
+{
+	if ( pcb->state == READY && pcb->class == REALTIME &&
+			! pcb->sched->rt_throttled ){
+		return &queue_realtime;
+	}
+	return get_queue_by_state( pcb->state );
+}
+
+
+/*! Adds a chunk to the PCB pool, and records it in the handle table.
+ *
+ * @return	Returns 1 on success, or 0 if memory is exhausted or the pool
+ *		already has as many slots as a handle can number.
+ *
+ * @private
+ */
+static int pool_add_chunk( void )
+{
+	pcb_chunk_t	**new_chunks;
+	unsigned long	new_max;
+	pcb_chunk_t	*chunk;
+
+	if ( pool_stats.capacity + PCB_POOL_CHUNK_SLOTS >
+			HANDLE_INDEX_MASK + 1 ) {
+		return 0;
+	}
+
+	/* Make room in the handle table, doubling it if needed. */
+	if ( pool_stats.chunks == pool_chunks_max ) {
+		new_max = pool_chunks_max ? 2*pool_chunks_max : 16;
+		new_chunks = (pcb_chunk_t **)sys_alloc_mem_nz(
+			new_max * sizeof(pcb_chunk_t *) );
+		if ( new_chunks == NULL ) {
+			return 0;
+		}
+		if ( pool_chunks != NULL ) {
+			memcpy( new_chunks, pool_chunks,
+				pool_stats.chunks * sizeof(pcb_chunk_t *) );
+			sys_free_mem( pool_chunks );
+		}
+		pool_chunks	= new_chunks;
+		pool_chunks_max	= new_max;
+	}
+
+	chunk = (pcb_chunk_t *)sys_alloc_mem( sizeof(pcb_chunk_t) );
+	if ( chunk == NULL ) {
+		return 0;
+	}
+
+	pool_chunks[pool_stats.chunks] = chunk;
+	pool_fresh	= chunk;
+	pool_fresh_used	= 0;
+	pool_stats.chunks++;
+	pool_stats.capacity += PCB_POOL_CHUNK_SLOTS;
+
+	return 1;
+}
+
+
 /*! Allocates memory for a new PCB, but does not initialize it.
  *
- * This function will also allocate memory for the PCB's stack, and initialize
- * the stack_top and stack_base members.
+ * The PCB, its cold part, and its stack come together from the PCB pool,
+ * which carves them from large chunks and recycles PCBs released by
+ * free_pcb().  This function initializes the cold and sched pointers and the
+ * stack_top, stack_base, and handle members; the stack is guaranteed to be
+ * all 0's.
  *
  * @return	Returns a pointer to the new PCB, or NULL if an error occured.
  */
 pcb_t* allocate_pcb (void)
 {
-	/* Pointer to the new PCB we will allocate. */
+	/* The PCB we will hand out. */
+	pcb_t *pcb;
+
+	if ( pool_free_list != NULL ) {
+		/* Re-use a PCB released by free_pcb(); its cold part and
+		 * stack are still attached. */
+		pcb = pool_free_list;
+		pool_free_list = pcb->queue_node.pcb;
+	} else {
+		if ( pool_fresh_used == PCB_POOL_CHUNK_SLOTS ) {
+			/* Out of never-used PCBs; get another chunk. */
+			if ( pool_add_chunk() == 0 ) {
+				return NULL;
+			}
+		}
+		/* sys_alloc_mem() zeroed the chunk, stacks included.  Each
+		 * slot's first handle has generation 1, so that no handle is
+		 * ever PCB_NO_HANDLE. */
+		pcb = &pool_fresh->pcb[pool_fresh_used];
+		pcb->cold = &pool_fresh->cold[pool_fresh_used];
+		pcb->sched = &pool_fresh->sched[pool_fresh_used];
+		pcb->cold->stack_base = pool_fresh->stack[pool_fresh_used];
+		pcb->cold->handle = (1UL << PCB_HANDLE_INDEX_BITS) |
+			( (pool_stats.chunks-1) * PCB_POOL_CHUNK_SLOTS +
+			  pool_fresh_used );
+		pool_fresh_used++;
+	}
+
+	pool_stats.in_use++;
+	if ( pool_stats.in_use > pool_stats.high_water ) {
+		pool_stats.high_water = pool_stats.in_use;
+	}
+
+	/* Initialize stack_top member. */
+	pcb->cold->stack_top = pcb->cold->stack_base + STACK_SIZE;
+
+	return pcb;
+}
+
+
+/*! De-allocates the memory that was used for a PCB.
+ *
+ * The PCB goes back to the PCB pool, and its name is released.  Its stack
+ * is cleared here, once, so that allocate_pcb() never has to.  The slot
+ * moves on to its next generation, so the PCB's handle becomes stale.
+ */
+void free_pcb (pcb_t *pcb)
+{
+	/* The PCB's entry in the process-name table. */
+	pcb_name_t *entry = NAME_ENTRY(pcb->name_id);
+
+	/* The slot's next generation (skipping 0). */
+	pcb_handle_t gen = ( HANDLE_GEN(pcb->cold->handle) + 1 ) &
+		HANDLE_GEN_MASK;
+
+	/* Never leave a dangling pointer in the process-name index. */
+	if ( entry->pcb == pcb ) {
+		entry->pcb = NULL;
+		name_index_count--;
+	}
+	release_name( pcb->name_id );
+	pcb->name_id = 0;
+
+	if ( gen == 0 ) {
+		gen = 1;
+	}
+	pcb->cold->handle = ( gen << PCB_HANDLE_INDEX_BITS ) |
+		HANDLE_INDEX( pcb->cold->handle );
+
+	memset( pcb->cold->stack_base, 0, STACK_SIZE );
+
+	if ( pcb->class == REALTIME ) {
+		release_realtime( pcb );
+	}
+	groups[pcb->group].members--;
+	if ( dispatched_pcb == pcb ) {
+		dispatched_pcb = NULL;
+	}
+
+	/* Free PCBs are chained through queue_node.pcb. */
+	pcb->queue_node.pcb = pool_free_list;
+	pool_free_list = pcb;
+
+	pool_stats.in_use--;
+}
+
+
+/*! Reports the occupancy of the PCB pool. */
+void get_pcb_pool_stats (
+	/*! [out] Receives a copy of the current pool statistics. */
+	pcb_pool_stats_t *stats
+)
+{
+	*stats = pool_stats;
+}
+
+
+/*! Creates, allocates, and initializes a new PCB object.
+ *
+ * This function creates a new PCB object (pcb_t), then calls allocate_pcb() to
+ * do the allocation step. It then initializes the PCB's various fields
+ * according to both default values and the parameters passed in.
+ *
+ * @return	Returns the new PCB's handle (see get_pcb()), or PCB_NO_HANDLE
+ *		if an error occured.
+ */
+pcb_handle_t setup_pcb (
+	/*! Name of the new process. Must be unique among all processes. */
+	char *name,
+	/*! Priority of the process. Must be between -127 and 128 (incl.) */
+	int priority,
+	/*! Class of the process; one of APPLICATION or SYSTEM.  (To make a
+	 *  real-time process, see set_pcb_realtime().) */
+	process_class_t class,
+	/*! The process group it joins (see set_pcb_group()); 0 for the
+	 *  default group. */
+	int group
+)
+{
+	/* Pointer to the new PCB we're creating. */
 	pcb_t *new_pcb;
 
-	/* Allocate memory for the PCB. */
-	new_pcb = (pcb_t *)sys_alloc_mem(sizeof(pcb_t));
-	if ( new_pcb == NULL ) {
-		/* Error allocating memory for the PCB. */
+	/* Id of the new PCB's (interned) name. */
+	pcb_name_id_t name_id;
+
+	/* Check that arguments are valid. */
+	if ( find_pcb(name) != NULL ) {
+		/* Name is not unique. */
+		return PCB_NO_HANDLE;
+	}
+	if ( strlen(name) > MAX_ARG_LEN || name == NULL ) {
+		/* Invalid name. */
+		return PCB_NO_HANDLE;
+	}
+	if ( priority < PRIORITY_MIN || priority > PRIORITY_MAX ) {
+		/* Value of priority is out of range. */
+		return PCB_NO_HANDLE;
+	}
+	if ( class != APPLICATION && class != SYSTEM ) {
+		/* Invalid class specified. */
+		return PCB_NO_HANDLE;
+	}
+	if ( get_group( group ) == NULL ) {
+		/* No such group. */
+		return PCB_NO_HANDLE;
+	}
+
+
+	/* Intern the name, and allocate the new PCB. */
+	name_id = intern_name( name );
+	if ( name_id == 0 ) {
+		/* Allocation error. */
+		return PCB_NO_HANDLE;
+	}
+	new_pcb = allocate_pcb();
+	if (new_pcb == NULL) {
+		/* Allocation error. */
+		release_name( name_id );
+		return PCB_NO_HANDLE;
+	}
+
+	
+	/* Set the given values. */
+	new_pcb->priority	= priority;
+	new_pcb->class		= class;
+	new_pcb->group		= (unsigned char)group;
+	new_pcb->name_id	= name_id;
+
+
+	/* Set other default values. */
+	new_pcb->state		= READY;
+	new_pcb->cold->memory_size	= 0;
+	new_pcb->cold->load_address	= NULL;
+	new_pcb->cold->exec_address	= NULL;
+	new_pcb->cold->stack_ptr	= new_pcb->cold->stack_top;
+	new_pcb->queue_node.next	= NULL;
+	new_pcb->queue_node.prev	= NULL;
+	new_pcb->queue_node.pcb		= new_pcb;
+	new_pcb->queue_node.queue	= NULL;
+	memset( new_pcb->sched, 0, sizeof(pcb_sched_t) );
+	new_pcb->sched->pcb		= new_pcb;
+	groups[group].members++;
+
+	/* The stack is already all 0's; see allocate_pcb(). */
+
+	return new_pcb->cold->handle;
+}
+
+
+/*! Finds a process.
+ *
+ * Looks the name up in the process-name index, so the cost does not depend
+ * on how many processes exist.
+ *
+ * @return Returns a pointer to the PCB, or NULL if not found or error.
+ */
+pcb_t* find_pcb(
+	/*! The name of the process to find. */
+	char *name
+)
+{
+	/* Id of the requested name, if any process has it. */
+	pcb_name_id_t id;
+
+	/* Validate arguments. */
+	if ( name == NULL || strlen(name) > MAX_ARG_LEN ) {
+		/* Invalid process name. */
+		return NULL;
+	}
+
+	id = name_lookup( name, hash_process_name(name) );
+	if ( id != 0 && NAME_ENTRY(id)->pcb != NULL ) {
+		return NAME_ENTRY(id)->pcb;
+	}
+
+	/* If we get to this point, the process is not in any queue.
+	 * ("Sorry Mario, your PCB is in another castle!") */
+	return NULL;
+}
+
+
+/*! Finds a process by its handle.
+ *
+ * The handle leads straight to the PCB's slot, so this takes constant time
+ * and never looks at a name.
+ *
+ * @return	Returns a pointer to the PCB, or NULL if the handle is stale
+ *		(the process has been freed) or was never valid.
+ */
+pcb_t* get_pcb(
+	/*! The handle of the process to find (see setup_pcb()). */
+	pcb_handle_t handle
+)
+{
+	/* Slot number the handle refers to. */
+	unsigned long index = HANDLE_INDEX(handle);
+
+	/* The PCB in that slot. */
+	pcb_t *pcb;
+
+	if ( index / PCB_POOL_CHUNK_SLOTS >= pool_stats.chunks ) {
+		return NULL;
+	}
+	pcb = &pool_chunks[index / PCB_POOL_CHUNK_SLOTS]->
+		pcb[index % PCB_POOL_CHUNK_SLOTS];
+
+	/* Slots that were never handed out have no cold part; free ones have
+	 * no name. */
+	if ( pcb->cold == NULL || pcb->cold->handle != handle ||
+			pcb->name_id == 0 ) {
+		return NULL;
+	}
+
+	return pcb;
+}
+
+
+/*! Returns the handle of a process.
+ *
+ * @return	Returns the handle, which stays valid until the PCB is freed.
+ */
+pcb_handle_t get_pcb_handle(
+	/*! The (allocated) PCB whose handle is wanted. */
+	pcb_t *pcb
+)
+{
+	return pcb->cold->handle;
+}
+
+
+/*! Returns the name of a process.
+ *
+ * Names are interned: each distinct name is stored once, in the
+ * process-name table, and the PCB only holds its id.
+ *
+ * @return	Returns a pointer to the name, which must not be modified.
+ */
+char* get_pcb_name(
+	/*! The (allocated) PCB whose name is wanted. */
+	pcb_t *pcb
+)
+{
+	return NAME_ENTRY(pcb->name_id)->text;
+}
+
+
+/*! Returns the ready process that should run next, without dequeuing it.
+ *
+ * Which process that is, is up to the scheduling policy; under the default
+ * policy, it is the highest-priority one, found in constant time.
+ *
+ * @return Returns a pointer to the PCB, or NULL if no process is ready.
+ */
+pcb_t* peek_ready_pcb( void )
+{
+	if ( queue_realtime.head != NULL ){
+		return queue_realtime.head->pcb;
+	}
+	if ( queue_ready.sort_order == POLICY ){
+		return sched_policy->pick_next( &queue_ready );
+	}
+	return queue_ready.head == NULL ? NULL : queue_ready.head->pcb;
+}
+
+
+/*! Takes the ready process that should run next out of the ready queue.
+ *
+ * The PCB's state stays READY, but it is in no queue (and so cannot be
+ * found by name) until it is put back: with preempt_pcb() if it is
+ * preempted, or with insert_pcb() once its state has been changed.
+ *
+ * @return Returns a pointer to the PCB, or NULL if no process is ready.
+ */
+pcb_t* dequeue_ready_pcb( void )
+{
+	pcb_t *pcb = peek_ready_pcb();
+
+	if ( pcb == NULL || remove_pcb( pcb ) == NULL ){
+		return NULL;
+	}
+	dispatched_pcb = pcb;
+	dispatched_at = sched_clock;
+	return pcb;
+}
+
+
+/*! Finds where a scan for PCBs of a given priority or lower should start.
+ *
+ * In a PRIORITY queue, this is the first node whose priority is no higher
+ * than \c priority; every node before it has a higher priority.  It is found
+ * with the queue's priority index, without walking the list.  In a FIFO
+ * queue, priority says nothing about position, so this is simply the head.
+ *
+ * @return	Returns the node, or NULL if no node can qualify.
+ */
+pcb_queue_node_t* first_node_at_or_below(
+	/*! The queue to search. */
+	pcb_queue_t	*queue,
+	/*! The highest priority of interest. */
+	int		priority
+)
+{
+	/* The closest non-empty level above the given priority. */
+	int higher_level;
+
+	if ( queue->sort_order != PRIORITY || priority >= PRIORITY_MAX ){
+		return queue->head;
+	}
+	if ( priority < PRIORITY_MIN ){
+		return NULL;
+	}
+
+	higher_level = find_level_above( queue->prio_index,
+		priority - PRIORITY_MIN );
+	if ( higher_level < 0 ){
+		return queue->head;
+	}
+	return queue->prio_index->level_tail[higher_level]->next;
+}
+
+
+/*! Finds where a tail-to-head scan for PCBs of a given priority or higher
+ *  should start.
+ *
+ * This is the mirror image of first_node_at_or_below(): in a PRIORITY
+ * queue it is the last node whose priority is no lower than \c priority,
+ * and in a FIFO queue it is simply the tail.
+ *
+ * @return	Returns the node, or NULL if no node can qualify.
+ */
+pcb_queue_node_t* last_node_at_or_above(
+	/*! The queue to search. */
+	pcb_queue_t	*queue,
+	/*! The lowest priority of interest. */
+	int		priority
+)
+{
+	/* The level of the given priority, and the closest non-empty level
+	 * above it. */
+	int level;
+	int higher_level;
+
+	if ( queue->sort_order != PRIORITY || priority <= PRIORITY_MIN ){
+		return queue->tail;
+	}
+	if ( priority > PRIORITY_MAX ){
+		return NULL;
+	}
+
+	level = priority - PRIORITY_MIN;
+	if ( queue->prio_index->level_tail[level] != NULL ){
+		return queue->prio_index->level_tail[level];
+	}
+
+	higher_level = find_level_above( queue->prio_index, level );
+	if ( higher_level < 0 ){
+		return NULL;
+	}
+	return queue->prio_index->level_tail[higher_level];
+}
+
+
+/*! Links a node into a queue's list, just after another node.
+ *
+ * Only the list (and its length) is updated; this is for scheduling
+ * policies that keep their own order (see sched_policy_t), and for
+ * queue_link().
+ */
+void link_queue_node(
+	/*! The queue. */
+	pcb_queue_t		*queue,
+	/*! The node to link in. */
+	pcb_queue_node_t	*node,
+	/*! The node it goes after, or NULL to put it at the head. */
+	pcb_queue_node_t	*after
+)
+{
+	node->prev = after;
+	if ( after == NULL ){
+		node->next = queue->head;
+		queue->head = node;
+	} else {
+		node->next = after->next;
+		after->next = node;
+	}
+	if ( node->next == NULL ){
+		queue->tail = node;
+	} else {
+		node->next->prev = node;
+	}
+
+	queue->length++;
+	if ( queue == &queue_ready ){
+		groups[node->pcb->group].ready++;
+	}
+}
+
+
+/*! Unlinks a node from a queue's list.
+ *
+ * Only the list (and its length) is updated, as for link_queue_node().
+ * The node's own links are left as they were.
+ */
+void unlink_queue_node(
+	/*! The queue. */
+	pcb_queue_t		*queue,
+	/*! The node to unlink. */
+	pcb_queue_node_t	*node
+)
+{
+	/* Fix forward links and head: */
+	if ( queue->head == node ){
+		queue->head = node->next;
+	} else {
+		node->prev->next = node->next;
+	}
+
+	/* Fix backward links and tail: */
+	if ( queue->tail == node ){
+		queue->tail = node->prev;
+	} else {
+		node->next->prev = node->prev;
+	}
+
+	/* Adjust queue's node count, and the group's: */
+	queue->length--;
+	if ( queue == &queue_ready ){
+		groups[node->pcb->group].ready--;
+	}
+}
+
+
+/*! Moves a run of consecutive nodes within a queue's list, keeping their
+ *  order, to just after another node; in constant time.
+ *
+ * Only the list is updated, as for link_queue_node(); this is for
+ * scheduling policies that keep their PCBs in runs (see sched_stride).
+ */
+void move_queue_run(
+	/*! The queue. */
+	pcb_queue_t		*queue,
+	/*! The first node of the run. */
+	pcb_queue_node_t	*first,
+	/*! The last node of the run (which may be \c first). */
+	pcb_queue_node_t	*last,
+	/*! The node the run goes after, which must not be in it; or NULL to
+	 *  put it at the head. */
+	pcb_queue_node_t	*after
+)
+{
+	if ( first->prev == after ){
+		/* It is already there. */
+		return;
+	}
+
+	/* Cut the run out ... */
+	if ( queue->head == first ){
+		queue->head = last->next;
+	} else {
+		first->prev->next = last->next;
+	}
+	if ( queue->tail == last ){
+		queue->tail = first->prev;
+	} else {
+		last->next->prev = first->prev;
+	}
+
+	/* ... and splice it back in. */
+	first->prev = after;
+	if ( after == NULL ){
+		last->next = queue->head;
+		queue->head = first;
+	} else {
+		last->next = after->next;
+		after->next = first;
+	}
+	if ( last->next == NULL ){
+		queue->tail = last;
+	} else {
+		last->next->prev = last;
+	}
+}
+
+
+/*! Unlinks a node from a queue, keeping the queue's priority index (if
+ *  any) up to date.
+ *
+ * In a POLICY queue, the scheduling policy's remove operation does this.
+ * The node's own links are left as they were; see remove_pcb().
+ *
+ * @private
+ */
+static void queue_unlink( pcb_queue_t *queue, pcb_queue_node_t *node )
+{
+	/* Priority-level index of the queue, for PRIORITY queues. */
+	pcb_priority_index_t *index;
+
+	/* Priority level of the PCB. */
+	int level;
+
+	/* If this node ends its priority level's run, the run now ends at the
+	 * previous node, unless that belongs to another level (in which case
+	 * this node was the whole run, and the level is now empty). */
+	if ( queue->sort_order == PRIORITY ){
+		index = queue->prio_index;
+		level = node->pcb->priority - PRIORITY_MIN;
+
+		if ( index->level_tail[level] == node ){
+			if ( node->prev != NULL &&
+				node->prev->pcb->priority == node->pcb->priority ){
+				index->level_tail[level] = node->prev;
+			} else {
+				index->level_tail[level] = NULL;
+				index->level_map[level/8] &=
+					(unsigned char)~(1 << (level%8));
+			}
+		}
+	} else if ( queue->sort_order == POLICY ){
+		/* The scheduling policy takes it from here. */
+		QUEUE_POLICY(queue)->remove( queue, node->pcb );
+		return;
+	}
+
+	unlink_queue_node( queue, node );
+}
+
+
+/*! Links a node into a queue, in the position its sort order calls for,
+ *  keeping the queue's priority index (if any) up to date.
+ *
+ * In a POLICY queue, the scheduling policy's enqueue operation does this.
+ *
+ * @private
+ */
+static void queue_link( pcb_queue_t *queue, pcb_queue_node_t *node )
+{
+	/* The node the new node will be linked in after (NULL = at head). */
+	pcb_queue_node_t	*after_node;
+	/* Priority-level index of the queue, for PRIORITY queues. */
+	pcb_priority_index_t	*index;
+	/* Priority level of the PCB, and the closest non-empty one above it. */
+	int			level;
+	int			higher_level;
+
+	/* For FIFO queues, we only need to insert at the end. */
+	after_node = queue->tail;
+
+	/* For PRIORITY queues, append to the end of the run for this PCB's
+	 * priority level; if that level is empty, start a new run just after
+	 * the closest higher level that has one (or at the head, if none). */
+	if ( queue->sort_order == PRIORITY ){
+		index = queue->prio_index;
+		level = node->pcb->priority - PRIORITY_MIN;
+
+		if ( index->level_tail[level] != NULL ){
+			after_node = index->level_tail[level];
+		} else {
+			higher_level = find_level_above( index, level );
+			if ( higher_level < 0 ){
+				after_node = NULL;
+			} else {
+				after_node = index->level_tail[higher_level];
+			}
+			index->level_map[level/8] |= (unsigned char)(1 << (level%8));
+		}
+		index->level_tail[level] = node;
+	} else if ( queue->sort_order == POLICY ){
+		/* The scheduling policy takes it from here. */
+		QUEUE_POLICY(queue)->enqueue( queue, node->pcb );
+		return;
+	}
+
+	link_queue_node( queue, node, after_node );
+}
+
+
+/* The "priority" scheduling policy (the default): the ready queue is a
+ * PRIORITY queue, so the highest-priority process runs first, and
+ * processes of equal priority take turns.  It needs no operations of its
+ * own (see sched_policy_t). */
+
+static int prio_start( pcb_queue_t *queue )
+{
+	init_priority_index( &prio_index_ready );
+	queue->sort_order = PRIORITY;
+	queue->prio_index = &prio_index_ready;
+	return 1;
+}
+
+static sched_policy_t sched_priority = {
+	"priority",
+	"highest priority first; round robin within a priority",
+	prio_start,
+	NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+
+/* The "fifo" scheduling policy: the ready queue is a FIFO queue, so
+ * processes run in the order they became ready, whatever their priority. */
+
+static int fifo_start( pcb_queue_t *queue )
+{
+	queue->sort_order = FIFO;
+	queue->prio_index = NULL;
+	return 1;
+}
+
+static sched_policy_t sched_fifo = {
+	"fifo",
+	"first come, first served; priority is ignored",
+	fifo_start,
+	NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+
+/*! Every scheduling policy, terminated by NULL; the first is the default.
+ */
+sched_policy_t *sched_policies[] = {
+	&sched_priority,
+	&sched_fifo,
+	&sched_cfs,
+	&sched_mlfq,
+	&sched_stride,
+	&sched_sjf,
+	NULL
+};
+
+
+/*! Removes a PCB from its queue.
+ *
+ * Given a pointer to a valid and en-queued PCP, this function will remove
+ * that PCB from the queue that it is in.
+ *
+ * The PCB's embedded queue node records which queue it is linked into, so
+ * this takes constant time no matter how long the queue is.
+ *
+ * However, this function will <em>not</em> modify the state member of the PCB;
+ * the caller is responsible for doing that, if the PCB is to be re-enqueued
+ * rather than de-allocated.
+ *
+ * @return
+ * 	Returns a pointer to the queue the PCB was removed from,
+ * 	or NULL if an error occurred.
+ */
+pcb_queue_t* remove_pcb (
+	/*! Pointer to the PCB to be de-queued. */
+	pcb_t *pcb
+)
+{
+	/* The PCB's own queue node. */
+	pcb_queue_node_t* this_node;
+
+	/* The queue we will soon try to remove the given PCB from. */
+	pcb_queue_t* queue = NULL;
+
+	/* Validate argument. */
+	if ( pcb == NULL ){
+		/* ERROR: Got NULL pointer for argument. */
+		return NULL;
+	}
+
+	this_node = &pcb->queue_node;
+	queue = this_node->queue;
+
+	/* Validate queue. */
+	if ( queue == NULL || queue != home_queue( pcb ) ){
+		/* ERROR: PCB isn't enqueued, or isn't in the queue its state
+		 * says it should be in. */
+		return NULL;
+	}
+
+	queue_unlink( queue, this_node );
+
+	/* Only enqueued PCBs are findable by name. */
+	NAME_ENTRY(pcb->name_id)->pcb = NULL;
+	name_index_count--;
+
+	/* The node lives inside the PCB, so there is nothing to de-allocate;
+	 * just clear the stale links. */
+	this_node->next		= NULL;
+	this_node->prev		= NULL;
+	this_node->queue	= NULL;
+
+	return queue;
+}
+
+
+/*! Inserts a PCB into the appropriate queue.
+ *
+ * Inspects the PCB's state member to determine which queue to insert into;
+ * a ready real-time process goes into the real-time queue, unless it is
+ * throttled (see update_realtime()).
+ *
+ * The scheduling policy decides where a PCB goes in the ready queue (see
+ * set_sched_policy()), and sched_edf in the real-time queue.  In the other
+ * queues, the queue's sort_order member determines whether to insert in
+ * order of priority, or to simply insert the PCB at the end of the queue.
+ * Either way this takes constant time; PCBs of equal priority stay in FIFO
+ * order.
+ *
+ * Fails if another enqueued PCB already has the same name.
+ *
+ * @return
+ * 	Returns a pointer to the queue the PCB was inserted into,
+ * 	or NULL if an error occurred.
+ */
+pcb_queue_t* insert_pcb (
+	/*! Pointer to the PCB to be enqueued. */
+	pcb_t *pcb
+)
+{
+	/* Pointer to the queue we will insert into. */
+	pcb_queue_t		*queue;
+	/* The PCB's own (embedded) queue node. */
+	pcb_queue_node_t	*new_queue_node;
+	/* The PCB's entry in the process-name table. */
+	pcb_name_t		*name_entry;
+
+	/* Validate argument */
+	if (pcb == NULL) {
+		/* PCB to insert cannot be null... come on :) */
+		return NULL;
+	}
+
+	/* The queue node is part of the PCB; nothing to allocate. */
+	new_queue_node = &pcb->queue_node;
+
+	/* A PCB can only be in one queue at a time. */
+	if ( new_queue_node->queue != NULL ){
+		return NULL;
+	}
+
+	/* Names must be unique among enqueued processes. */
+	name_entry = NAME_ENTRY(pcb->name_id);
+	if ( name_entry->pcb != NULL ){
+		return NULL;
+	}
+
+	/* A ready real-time process's job decides which queue it goes in. */
+	if ( pcb->state == READY && pcb->class == REALTIME ){
+		update_realtime( pcb, 0 );
+	}
+
+	/* Determine which queue we will insert this PCB into. */
+	queue = home_queue( pcb );
+	if ( queue == NULL ){
+		/* Unexpected value for PCB state (maybe Running?) */
 		return NULL;
 	}
 
-	/* Allocate memory for the PCB's stack. */
-	new_pcb->stack_base = (unsigned char *)sys_alloc_mem(STACK_SIZE);
-	if ( new_pcb->stack_base == NULL ) {
-		/* Error allocating memory for the PCB's stack. */
-		sys_free_mem(new_pcb);
-		return NULL;
-	}
 
-	/* Initialize stack_top member. */
-	new_pcb->stack_top = new_pcb->stack_base + STACK_SIZE;
+	/* Do the insert ... */
+	/* ----------------- */
+	
+	new_queue_node->pcb	= pcb;
+	new_queue_node->queue	= queue;
 
+	/* Make the PCB findable by name. */
+	name_entry->pcb = pcb;
+	name_index_count++;
 
-	return new_pcb;
+	queue_link( queue, new_queue_node );
+
+	return queue;
 }
 
 
-/*! De-allocates the memory that was used for a PCB. */
-void free_pcb (pcb_t *pcb)
+/*! Counts clock ticks that a process has run toward its group's recent
+ *  share of the CPU (see pcb_group_t::recent_ticks).
+ *
+ * @private
+ */
+static void charge_group( pcb_t *pcb, unsigned int ticks )
 {
-	sys_free_mem(pcb->stack_base);
-	sys_free_mem(pcb);
+	int i;
+
+	groups[pcb->group].recent_ticks += ticks;
+
+	group_share_clock += ticks;
+	if ( group_share_clock >= GROUP_SHARE_PERIOD ){
+		group_share_clock = 0;
+		for ( i = 0; i < PCB_MAX_GROUPS; i++ ){
+			groups[i].recent_ticks /= 2;
+		}
+	}
 }
 
 
-/*! Creates, allocates, and initializes a new PCB object.
+/*! Puts a process that was taken off the ready queue to run (see
+ *  dequeue_ready_pcb()) back into it, because it was preempted.
  *
- * This function creates a new PCB object (pcb_t), then calls allocate_pcb() to
- * do the allocation step. It then initializes the PCB's various fields
- * according to both default values and the parameters passed in.
+ * Unlike insert_pcb(), this tells the scheduling policy (or, for a
+ * real-time process, sched_edf) how long the process ran, so that it can
+ * take that into account; the time also counts toward the process's
+ * group's share of the CPU.
  *
- * @return	Returns a pointer to the new PCB, or NULL if an error occured.
+ * @return
+ * 	Returns a pointer to the queue the PCB was put in, or NULL if an
+ * 	error occurred (e.g., the PCB's state is not READY).
  */
-pcb_t* setup_pcb (
-	/*! Name of the new process. Must be unique among all processes. */
-	char *name,
-	/*! Priority of the process. Must be between -127 and 128 (incl.) */
-	int priority,
-	/*! Class of the process; one of APPLICATION or SYSTEM. */
-	process_class_t class
+pcb_queue_t* preempt_pcb(
+	/*! The PCB to put back. */
+	pcb_t		*pcb,
+	/*! How long it ran for, in clock ticks. */
+	unsigned int	 ticks
 )
 {
-	/* Loop index. */
-	int i;
+	/* The PCB's entry in the process-name table. */
+	pcb_name_t	*name_entry;
+	/* The queue it goes back into. */
+	pcb_queue_t	*queue;
 
-	/* Pointer to the new PCB we're creating. */
-	pcb_t *new_pcb;
-
-	/* Check that arguments are valid. */
-	if ( find_pcb(name) != NULL ) {
-		/* Name is not unique. */
+	if ( pcb == NULL || pcb->state != READY ||
+			pcb->queue_node.queue != NULL ){
 		return NULL;
 	}
-	if ( strlen(name) > MAX_ARG_LEN || name == NULL ) {
-		/* Invalid name. */
+	name_entry = NAME_ENTRY(pcb->name_id);
+	if ( name_entry->pcb != NULL ){
 		return NULL;
 	}
-	if ( priority < -127 || priority > 128 ) {
-		/* Value of priority is out of range. */
-		return NULL;
+
+	charge_group( pcb, ticks );
+	if ( pcb->class == REALTIME ){
+		update_realtime( pcb, ticks );
 	}
-	if ( class != APPLICATION && class != SYSTEM ) {
-		/* Invalid class specified. */
-		return NULL;
+
+	/* Only a POLICY queue has any use for the ticks. */
+	queue = home_queue( pcb );
+	if ( queue->sort_order != POLICY ){
+		return insert_pcb( pcb );
 	}
 
+	/* Otherwise, do what insert_pcb() would, but requeue the PCB. */
 
-	/* Allocate the new PCB. */
-	new_pcb = allocate_pcb();
-	if (new_pcb == NULL) {
-		/* Allocation error. */
-		return NULL;
-	}
+	pcb->queue_node.pcb	= pcb;
+	pcb->queue_node.queue	= queue;
+	name_entry->pcb = pcb;
+	name_index_count++;
 
-	
-	/* Set the given values. */
-	new_pcb->priority	= priority;
-	new_pcb->class		= class;
-	strcpy( new_pcb->name, name );
+	QUEUE_POLICY(queue)->requeue( queue, pcb, ticks );
 
+	return queue;
+}
 
-	/* Set other default values. */
-	new_pcb->state		= READY;
-	new_pcb->memory_size	= 0;
-	new_pcb->load_address	= NULL;
-	new_pcb->exec_address	= NULL;
 
-	/* Initialize the stack to 0's. */
-	memset( new_pcb->stack_base, 0, STACK_SIZE );
+/*! Returns how many clock ticks a process that has just been dispatched (see
+ *  dequeue_ready_pcb()) should run before it is preempted, as the
+ *  scheduling policy sees it. */
+unsigned int get_time_slice(
+	/*! The dispatched PCB. */
+	pcb_t *pcb
+)
+{
+	/* The policy in charge of the PCB. */
+	sched_policy_t *policy = QUEUE_POLICY( home_queue( pcb ) );
 
-	return new_pcb;
+	if ( policy->time_slice == NULL ){
+		return SCHED_TIME_SLICE;
+	}
+	return policy->time_slice( pcb );
 }
 
 
-/*! Search the given queue for the named process.
- *
- * @return Returns a pointer to the PCB, or NULL if not found or error.
+/*! Reads the scheduling clock: the number of clock ticks that have been
+ *  counted with advance_sched_clock().
  *
- * @private
+ * Real-time processes' deadlines (see set_pcb_realtime()) are set and
+ * checked by this clock.  It wraps around after 2^32 ticks; compare
+ * readings by the sign of their difference, as a long.
  */
-pcb_t* find_pcb_in_queue(
-	/*! The name of the process to find. */
-	char *name,
-	/*! The PCB queue in which to search for the process. */
-	pcb_queue_t *queue
+unsigned long get_sched_clock( void )
+{
+	return sched_clock;
+}
+
+
+/*! Moves the scheduling clock (see get_sched_clock()) forward; this is for
+ *  the dispatcher, or the clock interrupt.
+ */
+void advance_sched_clock(
+	/*! Number of clock ticks that have passed. */
+	unsigned int ticks
 )
 {
-	pcb_queue_node_t *this_queue_node = queue->head;
+	sched_clock += ticks;
+}
 
-	while (this_queue_node != NULL) {
-		if ( strcmp( this_queue_node->pcb->name, name) == 0 ) {
-			return this_queue_node->pcb;
-		}
-		this_queue_node = this_queue_node->next;
-	}
 
-	/* If we get here, we didn't find the process. */
-	return NULL;
+/*! Returns the scheduling policy in charge of the ready queue. */
+sched_policy_t* get_sched_policy( void )
+{
+	return sched_policy;
 }
 
 
-/*! Finds a process.
+/*! Puts the named scheduling policy (see sched_policies[]) in charge of the
+ *  ready queue.
  *
- * Searches all process queues.
+ * Every ready process is handed over from the old policy to the new one,
+ * in the order the old one would have run them; this takes time in
+ * proportion to the number of ready processes.
  *
- * @return Returns a pointer to the PCB, or NULL if not found or error.
+ * @return	Returns 1 on success, or 0 if there is no such policy or it
+ *		could not be started (in which case nothing changes).
  */
-pcb_t* find_pcb(
-	/*! The name of the process to find. */
+int set_sched_policy(
+	/*! Name of the policy. */
 	char *name
 )
 {
-	/* Pointer to the requested PCB, if we find it. */
-	pcb_t *found_pcb;
-
+	/* The new policy. */
+	sched_policy_t		*policy = NULL;
+	/* Ready PCBs, chained through their queue nodes while in between
+	 * policies. */
+	pcb_queue_node_t	*chain = NULL;
+	pcb_queue_node_t	**chain_end = &chain;
+	pcb_queue_node_t	*node;
+	pcb_queue_node_t	*next;
+	/* Whether the new policy could be started. */
+	int			 started;
 	/* Loop index. */
-	int i;
+	int			 i;
 
-	/* Validate arguments. */
-	if ( name == NULL || strlen(name) > MAX_ARG_LEN ) {
-		/* Invalid process name. */
-		return NULL;
+	for ( i = 0; sched_policies[i] != NULL; i++ ){
+		if ( strcmp( sched_policies[i]->name, name ) == 0 ){
+			policy = sched_policies[i];
+		}
+	}
+	if ( policy == NULL ){
+		return 0;
+	}
+	if ( policy == sched_policy ){
+		return 1;
 	}
 
-	/* Search each queue for the PCB; if we find it, return it: */
-	for ( i=0; i<4; i++ ){
+	/* Take the PCBs out, in the old policy's order. */
+	while ( queue_ready.head != NULL ){
+		node = queue_ready.head;
+		queue_unlink( &queue_ready, node );
+		node->next = NULL;
+		*chain_end = node;
+		chain_end = &node->next;
+	}
 
-		/* Search this specific queue for the PCB: */
-		found_pcb = find_pcb_in_queue( name, queues[i] );
+	started = policy->start( &queue_ready );
+	if ( ! started ){
+		/* Fall back on the old policy, which started before. */
+		policy = sched_policy;
+		policy->start( &queue_ready );
+	}
 
-		if ( found_pcb ){
-			/* We found it, so return it: */
-			return found_pcb;
-		}
+	sched_policy = policy;
+	for ( node = chain; node != NULL; node = next ){
+		next = node->next;
+		queue_link( &queue_ready, node );
 	}
 
-	/* If we get to this point, the process was not found in any queue.
-	 * ("Sorry Mario, your PCB is in another castle!") */
-	return NULL;
+	return started;
 }
 
 
-/*! Removes a PCB from its queue.
+/*! References a process group.
  *
- * Given a pointer to a valid and en-queued PCP, this function will remove
- * that PCB from the queue that it is in.
+ * @return	Returns the group, or NULL if there is no such group.
+ */
+pcb_group_t* get_group(
+	/*! The group's number, from 0 to PCB_MAX_GROUPS-1. */
+	int group
+)
+{
+	if ( group < 0 || group >= PCB_MAX_GROUPS ||
+			groups[group].name[0] == '\0' ){
+		return NULL;
+	}
+	return &groups[group];
+}
+
+
+/*! Finds a process group by name.
  *
- * However, this function will <em>not</em> modify the state member of the PCB;
- * the caller is responsible for doing that, if the PCB is to be re-enqueued
- * rather than de-allocated.
+ * @return	Returns the group's number, or -1 if there is no such group.
+ */
+int find_group(
+	/*! The group's name. */
+	char *name
+)
+{
+	int i;
+
+	for ( i = 0; i < PCB_MAX_GROUPS; i++ ){
+		if ( groups[i].name[0] != '\0' &&
+				strcmp( groups[i].name, name ) == 0 ){
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+/*! Sets the weight of a process group, creating the group if need be.
  *
- * @return
- * 	Returns a pointer to the queue the PCB was removed from,
- * 	or NULL if an error occurred.
+ * A group's weight only changes its share of the CPU from the next time
+ * one of its processes is charged for running.
+ *
+ * @return	Returns the group's number, or -1 if the name or weight is
+ *		invalid, or there is no room for another group.
  */
-pcb_queue_t* remove_pcb (
-	/*! Pointer to the PCB to be de-queued. */
-	pcb_t *pcb
+int set_group_weight(
+	/*! The group's name. */
+	char		*name,
+	/*! Its weight, from 1 to GROUP_WEIGHT_MAX. */
+	unsigned int	 weight
 )
 {
-	/* Loop index / iterator. */
-	pcb_queue_node_t* this_node;
+	int group;
 
-	/* The queue we will soon try to remove the given PCB from. */
-	pcb_queue_t* queue = NULL;
+	if ( name == NULL || name[0] == '\0' || strlen(name) > MAX_ARG_LEN ||
+			weight < 1 || weight > GROUP_WEIGHT_MAX ){
+		return -1;
+	}
 
-	/* Validate argument. */
-	if ( pcb == NULL ){
-		/* ERROR: Got NULL pointer for argument. */
-		return NULL;
+	group = find_group( name );
+	if ( group < 0 ){
+		for ( group = 0; group < PCB_MAX_GROUPS; group++ ){
+			if ( groups[group].name[0] == '\0' ){
+				break;
+			}
+		}
+		if ( group == PCB_MAX_GROUPS ){
+			return -1;
+		}
+		memset( &groups[group], 0, sizeof(pcb_group_t) );
+		strcpy( groups[group].name, name );
 	}
 
-	/* Fetch the queue that we will be removing this process from. */
-	queue = get_queue_by_state( pcb->state );
+	groups[group].weight = weight;
+	return group;
+}
 
-	/* Validate queue. */
-	if ( queue == NULL ){
-		/* ERROR: PCB seems to have invalid state assigned... */
-		return NULL;
+
+/*! Deletes a process group, which must have no processes.
+ *
+ * @return	Returns 1 on success, or 0 if there is no such group, it is
+ *		the default group, or it has processes.
+ */
+int delete_group(
+	/*! The group's number. */
+	int group
+)
+{
+	if ( group == 0 || get_group( group ) == NULL ||
+			groups[group].members > 0 ){
+		return 0;
 	}
+	groups[group].name[0] = '\0';
+	return 1;
+}
 
-	foreach_listitem( this_node, queue ){
-		if ( this_node->pcb == pcb ){
 
-			/* We've found our queue node.  Remove it:
-			 * --------------------------------------- */
+/*! Moves a process to another process group.
+ *
+ * A ready process under a policy that goes by group (see sched_stride) is
+ * moved to its new group's place in line; otherwise, the process stays
+ * where it is.  The process starts its new group on an even footing with
+ * the group's other processes.
+ *
+ * @return	Returns 1 on success, or 0 if there is no such group.
+ */
+int set_pcb_group(
+	/*! The PCB; it may or may not be enqueued. */
+	pcb_t	*pcb,
+	/*! The group's number. */
+	int	 group
+)
+{
+	/* The queue the PCB is in, if any, and whether it must be relinked
+	 * into it. */
+	pcb_queue_t	*queue = pcb->queue_node.queue;
+	int		 relink = queue == &queue_ready &&
+				  queue->sort_order == POLICY;
 
-			/* Fix forward links and head: */
-			if ( queue->head == this_node ){
-				queue->head = this_node->next;
-			} else {
-				this_node->prev->next = this_node->next;
-			}
+	if ( get_group( group ) == NULL ){
+		return 0;
+	}
+	if ( group == pcb->group ){
+		return 1;
+	}
 
-			/* Fix backward links and tail: */
-			if ( queue->tail == this_node ){
-				queue->tail = this_node->prev;
-			} else {
-				this_node->next->prev = this_node->prev;
-			}
+	if ( relink ){
+		queue_unlink( queue, &pcb->queue_node );
+	}
 
-			/* Adjust queue's node count: */
-			queue->length--;
-
-			/* And, de-allocate the queue descriptor (aka node):
-			 * (with check for error.) */
-			if ( sys_free_mem(this_node) != 0 ){
-				/* ERROR: failure freeing memory...
-				 *   Maybe we should just let this one slide,
-				 *   (as failure to free memory is not an
-				 *   immediately-fatal condition...),
-				 *   But for now, err on the side of caution. */
-				return NULL;
-			}
+	groups[pcb->group].members--;
+	groups[group].members++;
+	if ( queue == &queue_ready && ! relink ){
+		groups[pcb->group].ready--;
+		groups[group].ready++;
+	}
+	pcb->group = (unsigned char)group;
+	pcb->sched->remain = 0;
 
-			return queue;
-		}
+	if ( relink ){
+		queue_link( queue, &pcb->queue_node );
 	}
 
-	/* If, at this point, this_node is NULL, it means we didn't
-	 * find the PCB in the queue where it should have been... so,
-	 * ERROR: PCB wasn't found in the queue where it was expected. */
-	return NULL;
+	return 1;
 }
 
 
-/*! Inserts a PCB into the appropriate queue.
+/*! Changes the priority of a PCB, moving it within its queue if need be.
  *
- * Inspects the PCB's state member to determine which queue to insert into.
+ * A ready PCB is moved however the scheduling policy sees fit.  A PCB in
+ * another PRIORITY queue is unlinked and relinked at the end of its new
+ * priority level's run, just as if it had been removed and re-inserted;
+ * but it stays in the same queue and in the process-name index throughout,
+ * and nothing is allocated or freed.  Like insert_pcb(), this takes
+ * constant time.  Setting a PCB to the priority it already has does
+ * nothing (in particular, it does not lose its place in line).
  *
- * Inspects the queue's sort_order member to determine whether to insert in
- * order of priority, or to simply insert the PCB at the end of of the queue.
- *
- * @return
- * 	Returns a pointer to the queue the PCB was inserted into,
- * 	or NULL if an error occurred.
+ * @return	Returns 1 on success, or 0 if the priority is out of range.
  */
-pcb_queue_t* insert_pcb (
-	/*! Pointer to the PCB to be enqueued. */
-	pcb_t *pcb
+int set_pcb_priority(
+	/*! The PCB to change; it may or may not be enqueued. */
+	pcb_t	*pcb,
+	/*! The new priority. */
+	int	priority
 )
 {
-	/* Pointer to the queue we will insert into. */
-	pcb_queue_t		*queue;
-	/* Pointer to the new queue node descriptor we must make. */
-	pcb_queue_node_t	*new_queue_node;
-	/* For use in loops that iterating through the queue. */
-	pcb_queue_node_t	*iter_node;
+	/* The queue the PCB is in, if any. */
+	pcb_queue_t *queue = pcb->queue_node.queue;
 
-	/* Validate argument */
-	if (pcb == NULL) {
-		/* PCB to insert cannot be null... come on :) */
-		return NULL;
+	if ( priority < PRIORITY_MIN || priority > PRIORITY_MAX ){
+		return 0;
 	}
 
-	/* Determine which queue we will insert this PCB into. */
-	switch (pcb->state) {
-		case READY:
-			queue = &queue_ready;
-		break;
-		case BLOCKED:
-			queue = &queue_blocked;
-		break;
-		case SUSP_READY:
-			queue = &queue_susp_ready;
-		break;
-		case SUSP_BLOCKED:
-			queue = &queue_susp_blocked;
-		break;
-		default:
-			/* Unexpected value for PCB state (maybe Running?) */
-			return NULL;
-		break;
+	if ( priority == pcb->priority ){
+		return 1;
 	}
 
-	/* Allocate the new queue descriptor. */
-	new_queue_node =
-		(pcb_queue_node_t *)sys_alloc_mem(sizeof(pcb_queue_node_t));
-	if ( new_queue_node == NULL ){
-		/* Error allocating memory. */
-		return NULL;
+	if ( queue != NULL && queue->sort_order == POLICY ){
+		QUEUE_POLICY(queue)->change_prio( queue, pcb, priority );
+		return 1;
 	}
 
-
-	/* Do the insert ... */
-	/* ----------------- */
-	
-	new_queue_node->pcb = pcb;
-
-	/* Case one: queue is empty. */
-	if ( queue->length == 0 ){
-		new_queue_node->next	= NULL;
-		new_queue_node->prev	= NULL;
-		queue->head		= new_queue_node;
-		queue->tail		= new_queue_node;
-		queue->length		= 1;
-		return queue;
-	}
-
-	/* Case two: FIFO queue; we only need to insert at end. */
-	if ( queue->sort_order == FIFO ){
-		goto INSERT_AT_END;
-	}
-
-	/* The hard case: insert in priority-order. */
-	iter_node = queue->head;
-	while (iter_node != NULL) {
-		if ( iter_node->pcb->priority < pcb->priority ){
-			/* Insert before iter_node */
-			new_queue_node->prev = iter_node->prev;
-			iter_node->prev->next = new_queue_node;
-			iter_node->prev = new_queue_node;
-			new_queue_node->next = iter_node;
-			if ( queue->head == iter_node ){
-				queue->head = new_queue_node;
-			}
-			queue->length++;
-			return queue;
-		}
-		iter_node = iter_node->next;
+	if ( queue == NULL || queue->sort_order != PRIORITY ){
+		pcb->priority = priority;
+		return 1;
 	}
-	/* If we got this far, we need to do an insert-at-the-end. */
 
+	queue_unlink( queue, &pcb->queue_node );
+	pcb->priority = priority;
+	queue_link( queue, &pcb->queue_node );
 
-	INSERT_AT_END:
-		new_queue_node->next	= NULL;
-		new_queue_node->prev	= queue->tail;
-		queue->tail->next	= new_queue_node;
-		queue->tail		= new_queue_node;
-		queue->length++;
-		return queue;
+	return 1;
 }
 
 
 int block_pcb( pcb_t *pcb )
 {
+	/* The policy in charge of the PCB while it is ready. */
+	sched_policy_t *policy;
+
+	/* Clock ticks it has run since it was dispatched, if it was. */
+	unsigned int ticks = 0;
+
 	switch( pcb->state ){
 		case READY:
-			if ( ! remove_pcb(pcb) ) return 0;
+			/* It may be in the ready queue, or have been dispatched
+			 * (see dequeue_ready_pcb()). */
+			if ( pcb->queue_node.queue != NULL ){
+				if ( ! remove_pcb(pcb) ) return 0;
+			} else if ( pcb == dispatched_pcb ){
+				ticks = (unsigned int)( sched_clock -
+					dispatched_at );
+				charge_group( pcb, ticks );
+			}
+			/* A throttled real-time process ran as an ordinary
+			 * one; its job ends either way. */
+			policy = QUEUE_POLICY( home_queue( pcb ) );
 			pcb->state = BLOCKED;
+			if ( policy->block != NULL ){
+				policy->block( pcb, ticks );
+			}
+			if ( policy != &sched_edf && pcb->class == REALTIME ){
+				sched_edf.block( pcb, ticks );
+			}
 			if ( ! insert_pcb(pcb) ) return 0;
 		break;
 		case SUSP_READY:
@@ -570,6 +1911,130 @@ int is_ready( pcb_t *pcb )
 }
 
 
+#ifdef PCB_DEBUG
+/*! Checks one node of a PRIORITY queue against the priority-level index.
+ *
+ * @return	Returns the number of inconsistencies found.
+ *
+ * @private
+ */
+static int check_priority_run( pcb_queue_t *queue, pcb_queue_node_t *node )
+{
+	int errors = 0;
+	int level = node->pcb->priority - PRIORITY_MIN;
+	int is_run_end;
+
+	/* Runs must be in order of descending priority. */
+	if ( node->prev != NULL &&
+			node->prev->pcb->priority < node->pcb->priority ){
+		errors++;
+	}
+
+	/* The last node of each run must be recorded as its level's tail. */
+	is_run_end = ( node->next == NULL ||
+			node->next->pcb->priority != node->pcb->priority );
+	if ( is_run_end != (queue->prio_index->level_tail[level] == node) ){
+		errors++;
+	}
+	if ( !( queue->prio_index->level_map[level/8] & (1 << (level%8)) ) ){
+		errors++;
+	}
+
+	return errors;
+}
+
+
+/*! Cross-checks every queue against the PCBs' back-pointers.
+ *
+ * Walks each queue, verifying that the links are consistent in both
+ * directions, that the length and tail are right, that each node belongs to
+ * its PCB and points back at the queue it is actually in, that each PCB's
+ * state (and class) matches that queue, and that each PCB is in the
+ * process-name index and in a group; then has the scheduling policy (if it
+ * can) and sched_edf check their own data.
+ *
+ * This is O(number of processes), so it is only compiled in debug builds.
+ *
+ * @return	Returns the number of inconsistencies found (0 if all is well).
+ */
+int check_pcb_queues( void )
+{
+	/* Number of problems found so far. */
+	int errors = 0;
+
+	/* Loop index. */
+	int i;
+
+	/* Iterator, and the node we visited before it. */
+	pcb_queue_node_t *this_node;
+	pcb_queue_node_t *prev_node;
+
+	/* Number of nodes actually found in the queue. */
+	unsigned int count;
+
+	/* Number of nodes found in all of the queues. */
+	unsigned long total = 0;
+
+	/* Number of each group's members found in the ready queue. */
+	unsigned int ready[PCB_MAX_GROUPS];
+
+	for ( i=0; i<PCB_MAX_GROUPS; i++ ){
+		ready[i] = 0;
+	}
+
+	for ( i=0; i<5; i++ ){
+		prev_node = NULL;
+		count = 0;
+
+		foreach_listitem( this_node, queues[i] ){
+			if ( this_node->prev != prev_node ) errors++;
+			if ( this_node->queue != queues[i] ) errors++;
+			if ( this_node->pcb == NULL ) {
+				errors++;
+			} else {
+				if ( &this_node->pcb->queue_node != this_node )
+					errors++;
+				if ( home_queue(this_node->pcb) != queues[i] )
+					errors++;
+				if ( find_pcb(get_pcb_name(this_node->pcb))
+						!= this_node->pcb ) errors++;
+				if ( queues[i]->sort_order == PRIORITY )
+					errors += check_priority_run(
+						queues[i], this_node );
+				if ( get_group(this_node->pcb->group) == NULL )
+					errors++;
+				if ( queues[i] == &queue_ready )
+					ready[this_node->pcb->group]++;
+			}
+			prev_node = this_node;
+			count++;
+		}
+
+		if ( queues[i]->tail != prev_node ) errors++;
+		if ( queues[i]->length != count ) errors++;
+		total += count;
+	}
+
+	/* Every enqueued PCB is indexed, and nothing else is. */
+	if ( total != name_index_count ) errors++;
+
+	/* Each group's count of ready members is right. */
+	for ( i=0; i<PCB_MAX_GROUPS; i++ ){
+		if ( groups[i].ready != ready[i] ) errors++;
+	}
+
+	/* The scheduling policy's own data must agree with the ready queue,
+	 * and sched_edf's with the real-time queue. */
+	if ( sched_policy->check != NULL ){
+		errors += sched_policy->check( &queue_ready );
+	}
+	errors += sched_edf.check( &queue_realtime );
+
+	return errors;
+}
+#endif
+
+
 char* process_state_to_string( process_state_t state )
 {
         char *process_state = state == READY        ? "READY"        :
@@ -585,6 +2050,7 @@ char* process_class_to_string( process_class_t class )
 {
         char *process_class = class == APPLICATION ? "APPLICATION" :
                               class == SYSTEM      ? "SYSTEM"      :
+                              class == REALTIME    ? "REALTIME"    :
                                                           "?";
 	return process_class;
 }
@@ -594,6 +2060,7 @@ char process_class_to_char( process_class_t class )
 {
         char process_class = class == APPLICATION ? 'A' :
                              class == SYSTEM      ? 'S' :
+                             class == REALTIME    ? 'R' :
                                                          '?';
 	return process_class;
 }
@@ -10,10 +10,110 @@
 
 
 #include "mpx_util.h"
+#include "rbtree.h"
 
 
-/*! Amount of stack space to allocate for each process (in bytes). */
+/*! Amount of stack space to allocate for each process (in bytes).
+ *
+ * A PCB pool chunk holds PCB_POOL_CHUNK_SLOTS of these, so on the DOS target
+ * the two together must stay within one 64K segment. */
+#ifndef STACK_SIZE
 #define STACK_SIZE		1024
+#endif
+
+/*! Lowest valid process priority. */
+#define PRIORITY_MIN		(-127)
+
+/*! Highest valid process priority. */
+#define PRIORITY_MAX		128
+
+/*! Number of distinct process priorities. */
+#define PRIORITY_LEVELS		(PRIORITY_MAX - PRIORITY_MIN + 1)
+
+/*! Clock ticks a dispatched process runs before it is preempted, unless the
+ *  scheduling policy says otherwise (see get_time_slice()). */
+#define SCHED_TIME_SLICE	2
+
+/*! Number of PCB+stack slots the PCB pool allocates at a time.
+ *
+ * Each chunk is a single sys_alloc_mem() block, so on the DOS target it must
+ * stay within one 64K segment. */
+#ifndef PCB_POOL_CHUNK_SLOTS
+#define PCB_POOL_CHUNK_SLOTS	32
+#endif
+
+/*! Initial number of buckets in the process-name index (power of two). */
+#define PCB_INDEX_MIN_BUCKETS	64
+
+/*! Upper limit on the number of buckets in the process-name index.
+ *
+ * The bucket array is a single sys_alloc_mem() block, so on the DOS target it
+ * must stay within one 64K segment (which is more buckets than there is
+ * memory for processes).  Elsewhere there is room for as many names as there
+ * can be PCBs (see PCB_HANDLE_INDEX_BITS), so lookups stay constant time. */
+#ifndef PCB_INDEX_MAX_BUCKETS
+#ifdef __TURBOC__
+#define PCB_INDEX_MAX_BUCKETS	8192
+#else
+#define PCB_INDEX_MAX_BUCKETS \
+	( (1U << PCB_HANDLE_INDEX_BITS) / PCB_INDEX_MAX_LOAD )
+#endif
+#endif
+
+/*! The process-name index doubles once it holds this many names per bucket. */
+#define PCB_INDEX_MAX_LOAD	2
+
+/*! Number of bits of a pcb_handle_t that hold the PCB's slot number.
+ *
+ * The rest of the low 32 bits hold the slot's generation; more slot bits
+ * allow more PCBs, but leave fewer generations before a stale handle could
+ * match again. */
+#ifndef PCB_HANDLE_INDEX_BITS
+#define PCB_HANDLE_INDEX_BITS	20
+#endif
+
+/*! A pcb_handle_t that never refers to a process. */
+#define PCB_NO_HANDLE		0UL
+
+/*! The whole CPU, in the units real-time load is measured in; a real-time
+ *  process's load is RT_LOAD_SCALE * budget / deadline. */
+#define RT_LOAD_SCALE		10000
+
+/*! Greatest total load of the real-time processes that set_pcb_realtime()
+ *  will admit.
+ *
+ * Earliest-deadline-first meets every deadline as long as the total is at
+ * most RT_LOAD_SCALE; the rest is left for the other processes. */
+#ifndef RT_LOAD_BOUND
+#define RT_LOAD_BOUND		9000
+#endif
+
+/*! Greatest period, budget, or deadline of a real-time process, in clock
+ *  ticks. */
+#define RT_MAX_TICKS		32767
+
+/*! Greatest number of process groups (see set_pcb_group()), including the
+ *  default group, 0. */
+#ifndef PCB_MAX_GROUPS
+#define PCB_MAX_GROUPS		16
+#endif
+
+/*! Weight of the default group, and of a group created without one. */
+#define GROUP_WEIGHT_DEFAULT	100
+
+/*! Greatest weight a process group may have; the least is 1. */
+#define GROUP_WEIGHT_MAX	1000
+
+/*! Each group's count of the clock ticks its processes have run is halved
+ *  each time the groups run this many between them, so that it reflects
+ *  their recent share of the CPU (see pcb_group_t::recent_ticks). */
+#define GROUP_SHARE_PERIOD	1024
+
+/*! Number of entries in each page of the process-name table (power of two).
+ *
+ * Each page is a single sys_alloc_mem() block, so on the DOS target it must
+ * stay within one 64K segment. */
+#define PCB_NAME_PAGE_SIZE	64
 
 
 /*! Type for variables that hold the state of a process. */
@@ -31,27 +131,54 @@ typedef enum {
 typedef enum {
 
 	APPLICATION,
-	SYSTEM
+	SYSTEM,
+	REALTIME	/* only through set_pcb_realtime() */
 
 } process_class_t;
 
 
-/*! Process control block structure */
-typedef struct {
+/*! Identifies an interned process name; see get_pcb_name().
+ *
+ * Zero never identifies a name. */
+typedef unsigned int pcb_name_id_t;
 
-	/*! Name of the process (i.e., its argv[0] in unix-speak). */
-	char			name[MAX_ARG_LEN+1]; 
 
-	/*! Process class (differentiates applications from system processes. */
-	process_class_t		class;
+/*! Identifies a process, like a unix pid; see get_pcb().
+ *
+ * A handle is the number of the PCB pool slot that holds the PCB, plus a
+ * generation that changes each time the slot is freed, so a handle to a
+ * process that no longer exists is recognized as stale, even once its
+ * slot has been re-used. */
+typedef unsigned long pcb_handle_t;
 
-	/*! Process priority. Higher numerical value = higher priority.
-	 *
-	 * Valid values are -128 through 127 (inclusive). */
-	int			priority;
 
-	/*! Process state (Ready, Running, or Blocked). */
-	process_state_t		state;
+/*! PCB queue node; links a single PCB into a queue.
+ *
+ * Every PCB embeds exactly one of these (see pcb_t::queue_node), so moving a
+ * process between queues never allocates or frees memory. */
+typedef struct pcb_queue_node {
+
+	/*! Pointer to the next PCB node in the queue. */
+	struct pcb_queue_node	*next;
+
+	/*! Pointer to the previous PCB node in the queue. */
+	struct pcb_queue_node	*prev;
+
+	/*! Pointer to the actual PCB associated with this node. */
+	struct pcb		*pcb;
+
+	/*! Pointer to the queue this node is currently linked into, or NULL
+	 *  if the PCB is not enqueued. */
+	struct pcb_queue	*queue;
+
+} pcb_queue_node_t;
+
+
+/*! The parts of a process control block that scheduling never looks at.
+ *
+ * These are kept out of line (see pcb_t::cold), so that a walk along a
+ * queue only has to bring the small, hot pcb_t into the cache. */
+typedef struct pcb_cold {
 
 	/*! Pointer to the top of this processes's stack. */
 	unsigned char		*stack_top;
@@ -59,8 +186,9 @@ typedef struct {
 	/*! Pointer to the bottom of this processes's stack. */
 	unsigned char		*stack_base;
 
-	/*! Memory size ... will be used in R3 and R4. */
-	int			memory_size;
+	/*! The process's stack pointer while it is not running, with its
+	 *  register context saved just above it (see dispatch()). */
+	unsigned char		*stack_ptr;
 
 	/*! Load address ... will be used in R3 and R4. */
 	unsigned char		*load_address;
@@ -68,6 +196,143 @@ typedef struct {
 	/*! Execution address ... will be used in R3 and R4. */
 	unsigned char		*exec_address;
 
+	/*! Memory size ... will be used in R3 and R4. */
+	int			memory_size;
+
+	/*! Handle of this PCB's slot; while the PCB is allocated, this is the
+	 *  PCB's handle (see get_pcb_handle()). */
+	pcb_handle_t		handle;
+
+} pcb_cold_t;
+
+
+/*! The parts of a process control block that belong to the scheduling
+ *  policies (see sched_policy_t).
+ *
+ * These are kept out of line like pcb_cold_t, next to each other, so that
+ * a policy's own data structure can be walked without touching pcb_t's.
+ * setup_pcb() zeroes them. */
+typedef struct pcb_sched {
+
+	/*! Links the PCB into a policy's tree, or (for a real-time process)
+	 *  the real-time queue's. */
+	rb_node_t		tree_node;
+
+	/*! The PCB these belong to. */
+	struct pcb		*pcb;
+
+	/*! "cfs" policy: weighted CPU time used, which orders its tree. */
+	unsigned long		vruntime;
+
+	/*! "cfs" policy: how far vruntime was ahead of the least vruntime in
+	 *  the tree, when the PCB left it. */
+	long			lag;
+
+	/*! "mlfq" policy: the aging period in which level was last set; the
+	 *  level is only good for that period. */
+	unsigned long		epoch;
+
+	/*! "mlfq" policy: clock ticks run at the current level so far. */
+	unsigned int		used;
+
+	/*! "mlfq" policy: the PCB's level, 0 being the top. */
+	unsigned char		level;
+
+	/*! Real-time processes: non-zero while a job is under way (from the
+	 *  time the process becomes ready until it blocks). */
+	unsigned char		rt_active;
+
+	/*! Real-time processes: non-zero once the current job has missed its
+	 *  deadline. */
+	unsigned char		rt_missed;
+
+	/*! Real-time processes: non-zero while the current job has used up its
+	 *  budget, and the next is not yet due; the process then waits in the
+	 *  ready queue, as an ordinary process (see update_realtime()). */
+	unsigned char		rt_throttled;
+
+	/*! Real-time processes: the period, budget and (relative) deadline
+	 *  given to set_pcb_realtime(), in clock ticks. */
+	unsigned int		rt_period;
+	unsigned int		rt_budget;
+	unsigned int		rt_deadline;
+
+	/*! Real-time processes: the budget the current job has left. */
+	unsigned int		rt_left;
+
+	/*! Real-time processes: when the current job was released, by the
+	 *  scheduling clock (see get_sched_clock()). */
+	unsigned long		rt_release;
+
+	/*! Real-time processes: the current job's deadline, likewise; the
+	 *  release plus the relative deadline. */
+	unsigned long		rt_abs_deadline;
+
+	/*! Real-time processes: jobs released, and deadlines missed. */
+	unsigned long		rt_jobs;
+	unsigned long		rt_misses;
+
+	/*! "stride" policy: the PCB's pass within its group, which orders the
+	 *  group's tree. */
+	unsigned long		pass;
+
+	/*! "stride" policy: how far pass was ahead of (positive) or behind
+	 *  (negative) the least pass in the group's tree, when the PCB left
+	 *  it. */
+	long			remain;
+
+	/*! "sjf" policy: the average length of the process's past CPU bursts
+	 *  (from dispatch until it blocks), weighted toward recent ones, in
+	 *  sixteenths of a clock tick; 0 if it has not blocked yet. */
+	unsigned long		burst_avg;
+
+	/*! "sjf" policy: the prediction that orders its tree. */
+	unsigned long		burst_key;
+
+	/*! "sjf" policy: clock ticks run so far in the current burst. */
+	unsigned int		burst_run;
+
+} pcb_sched_t;
+
+
+/*! Process control block structure.
+ *
+ * Only what the queues and the scheduler touch is kept here, with the
+ * queue links first; on a 64-bit host the whole thing fits in one 64-byte
+ * cache line.  The name is interned (see get_pcb_name()), and everything
+ * else is in the out-of-line pcb_cold_t and pcb_sched_t. */
+typedef struct pcb {
+
+	/*! Links this PCB into the queue for its state; queue_node.pcb always
+	 *  points back at this PCB. */
+	pcb_queue_node_t	queue_node;
+
+	/*! Process priority. Higher numerical value = higher priority.
+	 *
+	 * Valid values are PRIORITY_MIN through PRIORITY_MAX (inclusive);
+	 * use set_pcb_priority() to change it while the PCB is enqueued. */
+	short			priority;
+
+	/*! Process state (Ready, Running, or Blocked); a process_state_t. */
+	unsigned char		state;
+
+	/*! Process class (differentiates applications from system
+	 *  processes); a process_class_t. */
+	unsigned char		class;
+
+	/*! The process group the process belongs to; use set_pcb_group() to
+	 *  change it. */
+	unsigned char		group;
+
+	/*! Name of the process (i.e., its argv[0] in unix-speak). */
+	pcb_name_id_t		name_id;
+
+	/*! The rest of the PCB; always valid, and never moves. */
+	pcb_cold_t		*cold;
+
+	/*! The scheduling policies' part of the PCB; likewise. */
+	pcb_sched_t		*sched;
+
 } pcb_t;
 
 
@@ -75,24 +340,29 @@ typedef struct {
 typedef enum {
 
 	FIFO,
-	PRIORITY
+	PRIORITY,
+	POLICY		/* the ready queues only; see sched_policy_t */
 
 } pcb_queue_sort_order_t;
 
 
-/* PCB queue node; points to a single PCB that is associated with this node. */
-typedef struct pcb_queue_node {
-
-	/*! Pointer to the next PCB node in the queue. */
-	struct pcb_queue_node	*next;
+/*! Per-priority index for a PRIORITY-sorted queue.
+ *
+ * A PRIORITY queue is still one doubly-linked list, but it is made up of
+ * back-to-back FIFO runs, one per priority level, from highest to lowest.
+ * This index remembers where each run ends and which runs are non-empty, so
+ * that a PCB can be appended to its run without walking the list. */
+typedef struct pcb_priority_index {
 
-	/*! Pointer to the previous PCB node in the queue. */
-	struct pcb_queue_node	*prev;
+	/*! Last node of each priority level's run, or NULL if the level is
+	 *  empty; indexed by (priority - PRIORITY_MIN). */
+	pcb_queue_node_t	*level_tail[PRIORITY_LEVELS];
 
-	/*! Pointer to the actual PCB associated with this node. */
-	pcb_t			*pcb;
+	/*! Occupancy bitmap; bit (n % 8) of byte (n / 8) is set if and only
+	 *  if level n is non-empty. */
+	unsigned char		level_map[PRIORITY_LEVELS/8];
 
-} pcb_queue_node_t;
+} pcb_priority_index_t;
 
 
 /*! PCB queue; represents a queue of processes. */
@@ -110,9 +380,182 @@ typedef struct pcb_queue {
 	/*! Specifies how elements in this queue are sorted at insert-time. */
 	pcb_queue_sort_order_t	sort_order;
 
+	/*! Priority-level index; used only when sort_order is PRIORITY. */
+	pcb_priority_index_t	*prio_index;
+
 } pcb_queue_t;
 
 
+/*! Occupancy statistics for the PCB pool (see get_pcb_pool_stats()). */
+typedef struct pcb_pool_stats {
+
+	/*! Number of PCBs currently allocated. */
+	unsigned long		in_use;
+
+	/*! Largest value in_use has ever had. */
+	unsigned long		high_water;
+
+	/*! Total number of slots in all chunks, used or free. */
+	unsigned long		capacity;
+
+	/*! Number of chunks obtained from sys_alloc_mem(). */
+	unsigned long		chunks;
+
+} pcb_pool_stats_t;
+
+
+/*! A process group: a set of processes that share the CPU as one, in
+ *  proportion to the group's weight, under the "stride" policy.
+ *
+ * Groups are numbered from 0 to PCB_MAX_GROUPS-1 (see get_group()); group
+ * 0, "default", always exists, and every process starts out in it unless
+ * setup_pcb() is told otherwise.  The members are counted under any
+ * policy, and so is the CPU time they get, so that it can be compared
+ * with the share the group is due. */
+typedef struct pcb_group {
+
+	/*! Name of the group; empty if the group does not exist. */
+	char			name[MAX_ARG_LEN+1];
+
+	/*! The group's weight, from 1 to GROUP_WEIGHT_MAX. */
+	unsigned int		weight;
+
+	/*! Number of processes in the group. */
+	unsigned int		members;
+
+	/*! Number of members in the ready queue; kept by link_queue_node()
+	 *  and unlink_queue_node(). */
+	unsigned int		ready;
+
+	/*! Clock ticks the members have run, as counted by preempt_pcb() and
+	 *  block_pcb(); halved every GROUP_SHARE_PERIOD ticks run by all of
+	 *  the groups, so it is weighted toward recent use. */
+	unsigned long		recent_ticks;
+
+	/*! "stride" policy: links the group into the tree of groups with
+	 *  ready processes. */
+	rb_node_t		tree_node;
+
+	/*! "stride" policy: the group's ready PCBs, by pass. */
+	rb_tree_t		tree;
+
+	/*! "stride" policy: the group's pass, which orders the tree of
+	 *  groups. */
+	unsigned long		pass;
+
+	/*! "stride" policy: how far pass was ahead of or behind the least
+	 *  pass among the groups, when the group last left their tree. */
+	long			remain;
+
+	/*! "stride" policy: the least pass in the group's tree (or the last
+	 *  there was). */
+	unsigned long		min_pass;
+
+	/*! "stride" policy: the first and last nodes of the group's run in
+	 *  the ready queue's list, or NULL. */
+	pcb_queue_node_t	*head;
+	pcb_queue_node_t	*tail;
+
+} pcb_group_t;
+
+
+/*! Totals for the real-time processes (see get_realtime_stats()). */
+typedef struct pcb_rt_stats {
+
+	/*! Number of real-time processes. */
+	unsigned int		processes;
+
+	/*! Their total load (see RT_LOAD_SCALE). */
+	unsigned int		load;
+
+	/*! Jobs released, and deadlines missed, by all real-time processes
+	 *  there have been. */
+	unsigned long		jobs;
+	unsigned long		misses;
+
+} pcb_rt_stats_t;
+
+
+/*! A scheduling policy: decides the order in which ready processes run.
+ *
+ * The ready queue hands every PCB that enters or leaves it to the current
+ * policy (see set_sched_policy()), through these operations.  Whatever
+ * else a policy keeps, it keeps every ready PCB linked into the ready
+ * queue's list, in the order it would dispatch them as things stand; so
+ * walking that list (e.g., with foreach_listitem()) iterates over the
+ * ready processes under any policy.
+ *
+ * Operations are only ever given PCBs whose state is READY (except for
+ * block), and the queue is always the ready queue.  Suspended and blocked
+ * processes are otherwise never seen by the policy, and neither are
+ * real-time processes, unless they are throttled (see update_realtime()):
+ * they have a ready queue of their own (see get_realtime_queue()), which is
+ * always dispatched first, and which sched_edf runs through these same
+ * operations.
+ *
+ * A policy that only needs the ready queue to be kept in FIFO or PRIORITY
+ * order just sets its sort_order in start, and leaves the other operations
+ * NULL; the queue then does the work itself, at no cost for being
+ * pluggable.  Otherwise, start sets sort_order to POLICY, and every
+ * operation from enqueue through change_prio must be provided;
+ * link_queue_node() and unlink_queue_node() maintain the list.  The rest
+ * are optional under any policy. */
+typedef struct sched_policy {
+
+	/*! Name of the policy, as given to set_sched_policy(). */
+	char	*name;
+
+	/*! One-line description of the policy. */
+	char	*description;
+
+	/*! Sets up the policy's own data, and the queue's sort order; the
+	 *  queue is empty.  Returns 1 on success, or 0 on failure. */
+	int	(*start)	( pcb_queue_t *queue );
+
+	/*! Adds a PCB that has just become ready. */
+	void	(*enqueue)	( pcb_queue_t *queue, pcb_t *pcb );
+
+	/*! Puts back a PCB that was preempted after running for \c ticks. */
+	void	(*requeue)	( pcb_queue_t *queue, pcb_t *pcb,
+				  unsigned int ticks );
+
+	/*! Takes a PCB out of the ready set. */
+	void	(*remove)	( pcb_queue_t *queue, pcb_t *pcb );
+
+	/*! Returns the PCB that should run next, without removing it; or
+	 *  NULL if the queue is empty. */
+	pcb_t*	(*pick_next)	( pcb_queue_t *queue );
+
+	/*! Sets an enqueued PCB's priority, moving it as need be. */
+	void	(*change_prio)	( pcb_queue_t *queue, pcb_t *pcb,
+				  int priority );
+
+	/*! Checks the policy's own data against the queue, for
+	 *  check_pcb_queues(); returns the number of problems found.  May be
+	 *  NULL. */
+	int	(*check)	( pcb_queue_t *queue );
+
+	/*! Told that a PCB has left the ready set because it blocked (see
+	 *  block_pcb()), after running for \c ticks since it was dispatched
+	 *  (0 if it was not running); its state is already BLOCKED.  May be
+	 *  NULL. */
+	void	(*block)	( pcb_t *pcb, unsigned int ticks );
+
+	/*! Changes the policy's settings while it is in charge, from shell
+	 *  arguments (see the sched command); returns 1 on success, or 0 if
+	 *  they are invalid, in which case nothing changes.  Given a NULL
+	 *  queue, it only checks the arguments, and changes nothing either
+	 *  way.  May be NULL, if the policy has no settings. */
+	int	(*tune)		( pcb_queue_t *queue, int argc, char *argv[] );
+
+	/*! Returns how many clock ticks a PCB that has just been dispatched
+	 *  should run before it is preempted.  May be NULL, for
+	 *  SCHED_TIME_SLICE. */
+	unsigned int (*time_slice) ( pcb_t *pcb );
+
+} sched_policy_t;
+
+
 /* MACROS *
  * ------ */
 
@@ -201,6 +644,12 @@ typedef struct pcb_queue {
 /* EXTERNS *
  * ------- */
 extern pcb_queue_t   *queues[];
+extern sched_policy_t *sched_policies[];
+extern sched_policy_t sched_cfs;
+extern sched_policy_t sched_mlfq;
+extern sched_policy_t sched_stride;
+extern sched_policy_t sched_sjf;
+extern sched_policy_t sched_edf;
 
 
 
@@ -212,10 +661,49 @@ extern pcb_queue_t   *queues[];
 
 void		init_pcb_queues		( void );
 pcb_queue_t*	get_queue_by_state	( process_state_t state );
-pcb_t*		setup_pcb   ( char *name, int priority, process_class_t class );
+pcb_queue_t*	get_realtime_queue	( void );
+pcb_handle_t	setup_pcb		( char *name, int priority,
+					  process_class_t class, int group );
+void		free_pcb		( pcb_t *pcb );
+void		get_pcb_pool_stats	( pcb_pool_stats_t *stats );
 pcb_t*		find_pcb		( char *name );
+pcb_t*		get_pcb			( pcb_handle_t handle );
+pcb_handle_t	get_pcb_handle		( pcb_t *pcb );
+char*		get_pcb_name		( pcb_t *pcb );
+pcb_t*		peek_ready_pcb		( void );
+pcb_t*		dequeue_ready_pcb	( void );
+pcb_queue_t*	preempt_pcb		( pcb_t *pcb, unsigned int ticks );
+unsigned int	get_time_slice		( pcb_t *pcb );
+unsigned long	get_sched_clock		( void );
+void		advance_sched_clock	( unsigned int ticks );
+int		set_pcb_realtime	( pcb_t *pcb, unsigned int period,
+					  unsigned int budget,
+					  unsigned int deadline );
+void		update_realtime		( pcb_t *pcb, unsigned int ticks );
+void		release_realtime	( pcb_t *pcb );
+void		get_realtime_stats	( pcb_rt_stats_t *stats );
+unsigned long	get_burst_estimate	( pcb_t *pcb );
+pcb_group_t*	get_group		( int group );
+int		find_group		( char *name );
+int		set_group_weight	( char *name, unsigned int weight );
+int		delete_group		( int group );
+int		set_pcb_group		( pcb_t *pcb, int group );
+sched_policy_t*	get_sched_policy	( void );
+int		set_sched_policy	( char *name );
+pcb_queue_node_t* first_node_at_or_below ( pcb_queue_t *queue, int priority );
+pcb_queue_node_t* last_node_at_or_above  ( pcb_queue_t *queue, int priority );
+void		link_queue_node		( pcb_queue_t *queue,
+					  pcb_queue_node_t *node,
+					  pcb_queue_node_t *after );
+void		unlink_queue_node	( pcb_queue_t *queue,
+					  pcb_queue_node_t *node );
+void		move_queue_run		( pcb_queue_t *queue,
+					  pcb_queue_node_t *first,
+					  pcb_queue_node_t *last,
+					  pcb_queue_node_t *after );
 pcb_queue_t*	remove_pcb		( pcb_t *pcb );
 pcb_queue_t*	insert_pcb		( pcb_t *pcb );
+int		set_pcb_priority	( pcb_t *pcb, int priority );
 int		block_pcb		( pcb_t *pcb );
 int		unblock_pcb		( pcb_t *pcb );
 int		suspend_pcb		( pcb_t *pcb );
@@ -227,5 +715,9 @@ char*		process_state_to_string	( process_state_t state );
 char*		process_class_to_string	( process_class_t class );
 char		process_class_to_char	( process_class_t class );
 
+#ifdef PCB_DEBUG
+int		check_pcb_queues	( void );
+#endif
+
 
 #endif
@@ -0,0 +1,462 @@
+/*!
+ * @file	rbtree.c
+ * @brief	Intrusive red-black trees
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ *
+ * A red-black tree keeps its nodes in sorted order, and stays balanced, so
+ * that inserting or removing a node takes O(log n) time.  Nodes that
+ * compare equal are kept in the order they were inserted.
+ *
+ * Missing children are NULL, and count as black.
+ */
+
+
+#include "rbtree.h"
+#include <stddef.h>
+
+
+/*! Tells whether a node (possibly NULL) is red. */
+#define IS_RED(node)	( (node) != NULL && (node)->red )
+
+
+/*! Rotates \c node down to the left; its right child takes its place.
+ *
+ * @private
+ */
+static void rotate_left( rb_tree_t *tree, rb_node_t *node )
+{
+	rb_node_t *child = node->right;
+
+	node->right = child->left;
+	if ( child->left != NULL ){
+		child->left->parent = node;
+	}
+
+	child->parent = node->parent;
+	if ( node->parent == NULL ){
+		tree->root = child;
+	} else if ( node == node->parent->left ){
+		node->parent->left = child;
+	} else {
+		node->parent->right = child;
+	}
+
+	child->left = node;
+	node->parent = child;
+}
+
+
+/*! Rotates \c node down to the right; its left child takes its place.
+ *
+ * @private
+ */
+static void rotate_right( rb_tree_t *tree, rb_node_t *node )
+{
+	rb_node_t *child = node->left;
+
+	node->left = child->right;
+	if ( child->right != NULL ){
+		child->right->parent = node;
+	}
+
+	child->parent = node->parent;
+	if ( node->parent == NULL ){
+		tree->root = child;
+	} else if ( node == node->parent->right ){
+		node->parent->right = child;
+	} else {
+		node->parent->left = child;
+	}
+
+	child->right = node;
+	node->parent = child;
+}
+
+
+/*! Puts the subtree rooted at \c with (which may be NULL) where the
+ *  subtree rooted at \c node was.
+ *
+ * @private
+ */
+static void replace_subtree( rb_tree_t *tree, rb_node_t *node, rb_node_t *with )
+{
+	if ( node->parent == NULL ){
+		tree->root = with;
+	} else if ( node == node->parent->left ){
+		node->parent->left = with;
+	} else {
+		node->parent->right = with;
+	}
+
+	if ( with != NULL ){
+		with->parent = node->parent;
+	}
+}
+
+
+/*! Makes a tree empty.
+ *
+ * Nodes that were in the tree are simply forgotten.
+ */
+void rb_init(
+	/*! The tree. */
+	rb_tree_t	*tree,
+	/*! The function that will order the tree's nodes. */
+	rb_compare_t	 compare
+)
+{
+	tree->root	= NULL;
+	tree->first	= NULL;
+	tree->count	= 0;
+	tree->compare	= compare;
+}
+
+
+/*! Adds a node to a tree.
+ *
+ * The node goes after every node that it compares equal to.
+ *
+ * @return	Returns the node just before the new one (in sorted order),
+ *		or NULL if the new node is now first.
+ */
+rb_node_t* rb_insert(
+	/*! The tree. */
+	rb_tree_t	*tree,
+	/*! The node to add; it must not already be in a tree. */
+	rb_node_t	*node
+)
+{
+	/* The node we are looking at, and the new node's parent-to-be. */
+	rb_node_t	*this_node = tree->root;
+	rb_node_t	*parent = NULL;
+	/* The last node we went right from (the new node's predecessor). */
+	rb_node_t	*before = NULL;
+	/* Whether the new node is a left child. */
+	int		 is_left = 0;
+	/* The new node's grandparent and uncle, while re-balancing. */
+	rb_node_t	*grandparent;
+	rb_node_t	*uncle;
+
+	while ( this_node != NULL ){
+		parent = this_node;
+		if ( tree->compare( node, this_node ) < 0 ){
+			is_left = 1;
+			this_node = this_node->left;
+		} else {
+			is_left = 0;
+			before = this_node;
+			this_node = this_node->right;
+		}
+	}
+
+	node->parent	= parent;
+	node->left	= NULL;
+	node->right	= NULL;
+	node->red	= 1;
+
+	if ( parent == NULL ){
+		tree->root = node;
+	} else if ( is_left ){
+		parent->left = node;
+	} else {
+		parent->right = node;
+	}
+
+	if ( before == NULL ){
+		tree->first = node;
+	}
+	tree->count++;
+
+	/* A red node may not have a red parent; repaint and rotate, moving
+	 * up the tree, until that holds. */
+	while ( IS_RED(node->parent) ){
+		parent = node->parent;
+		grandparent = parent->parent;
+
+		if ( parent == grandparent->left ){
+			uncle = grandparent->right;
+			if ( IS_RED(uncle) ){
+				parent->red = 0;
+				uncle->red = 0;
+				grandparent->red = 1;
+				node = grandparent;
+				continue;
+			}
+			if ( node == parent->right ){
+				rotate_left( tree, parent );
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = 0;
+			grandparent->red = 1;
+			rotate_right( tree, grandparent );
+		} else {
+			uncle = grandparent->left;
+			if ( IS_RED(uncle) ){
+				parent->red = 0;
+				uncle->red = 0;
+				grandparent->red = 1;
+				node = grandparent;
+				continue;
+			}
+			if ( node == parent->left ){
+				rotate_right( tree, parent );
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = 0;
+			grandparent->red = 1;
+			rotate_left( tree, grandparent );
+		}
+	}
+	tree->root->red = 0;
+
+	return before;
+}
+
+
+/*! Removes a node from a tree.
+ */
+void rb_remove(
+	/*! The tree. */
+	rb_tree_t	*tree,
+	/*! The node to remove; it must be in the tree. */
+	rb_node_t	*node
+)
+{
+	/* The node that actually leaves its place in the tree (node itself,
+	 * or its successor, which then takes node's place), and its color. */
+	rb_node_t	*moved = node;
+	int		 moved_red = node->red;
+	/* The node (possibly NULL) that takes moved's old place, and its
+	 * parent. */
+	rb_node_t	*child;
+	rb_node_t	*parent;
+	/* child's sibling, while re-balancing. */
+	rb_node_t	*sibling;
+
+	if ( tree->first == node ){
+		tree->first = rb_next( node );
+	}
+	tree->count--;
+
+	if ( node->left == NULL ){
+		child = node->right;
+		parent = node->parent;
+		replace_subtree( tree, node, child );
+	} else if ( node->right == NULL ){
+		child = node->left;
+		parent = node->parent;
+		replace_subtree( tree, node, child );
+	} else {
+		moved = node->right;
+		while ( moved->left != NULL ){
+			moved = moved->left;
+		}
+		moved_red = moved->red;
+		child = moved->right;
+
+		if ( moved->parent == node ){
+			parent = moved;
+		} else {
+			parent = moved->parent;
+			replace_subtree( tree, moved, child );
+			moved->right = node->right;
+			moved->right->parent = moved;
+		}
+
+		replace_subtree( tree, node, moved );
+		moved->left = node->left;
+		moved->left->parent = moved;
+		moved->red = node->red;
+	}
+
+	if ( moved_red ){
+		return;
+	}
+
+	/* A black node has left the path to child, so that path is one black
+	 * node short; repaint and rotate, moving up the tree, until it is
+	 * not. */
+	while ( child != tree->root && !IS_RED(child) ){
+		if ( child == parent->left ){
+			sibling = parent->right;
+			if ( sibling->red ){
+				sibling->red = 0;
+				parent->red = 1;
+				rotate_left( tree, parent );
+				sibling = parent->right;
+			}
+			if ( !IS_RED(sibling->left) && !IS_RED(sibling->right) ){
+				sibling->red = 1;
+				child = parent;
+				parent = child->parent;
+				continue;
+			}
+			if ( !IS_RED(sibling->right) ){
+				sibling->left->red = 0;
+				sibling->red = 1;
+				rotate_right( tree, sibling );
+				sibling = parent->right;
+			}
+			sibling->red = parent->red;
+			parent->red = 0;
+			sibling->right->red = 0;
+			rotate_left( tree, parent );
+		} else {
+			sibling = parent->left;
+			if ( sibling->red ){
+				sibling->red = 0;
+				parent->red = 1;
+				rotate_right( tree, parent );
+				sibling = parent->left;
+			}
+			if ( !IS_RED(sibling->left) && !IS_RED(sibling->right) ){
+				sibling->red = 1;
+				child = parent;
+				parent = child->parent;
+				continue;
+			}
+			if ( !IS_RED(sibling->left) ){
+				sibling->right->red = 0;
+				sibling->red = 1;
+				rotate_left( tree, sibling );
+				sibling = parent->left;
+			}
+			sibling->red = parent->red;
+			parent->red = 0;
+			sibling->left->red = 0;
+			rotate_right( tree, parent );
+		}
+		child = tree->root;
+	}
+
+	if ( child != NULL ){
+		child->red = 0;
+	}
+}
+
+
+/*! Returns the first node of a tree (in sorted order), or NULL if the tree
+ *  is empty; in constant time. */
+rb_node_t* rb_first( rb_tree_t *tree )
+{
+	return tree->first;
+}
+
+
+/*! Returns the node after \c node (in sorted order), or NULL if it is the
+ *  last. */
+rb_node_t* rb_next( rb_node_t *node )
+{
+	if ( node->right != NULL ){
+		node = node->right;
+		while ( node->left != NULL ){
+			node = node->left;
+		}
+		return node;
+	}
+
+	while ( node->parent != NULL && node == node->parent->right ){
+		node = node->parent;
+	}
+	return node->parent;
+}
+
+
+/*! Returns the node before \c node (in sorted order), or NULL if it is the
+ *  first. */
+rb_node_t* rb_prev( rb_node_t *node )
+{
+	if ( node->left != NULL ){
+		node = node->left;
+		while ( node->right != NULL ){
+			node = node->right;
+		}
+		return node;
+	}
+
+	while ( node->parent != NULL && node == node->parent->left ){
+		node = node->parent;
+	}
+	return node->parent;
+}
+
+
+/*! Checks the subtree rooted at \c node, and counts its black height.
+ *
+ * @private
+ */
+static void check_subtree(
+	rb_tree_t	*tree,
+	rb_node_t	*node,
+	int		*black_height,
+	unsigned long	*count,
+	int		*errors
+)
+{
+	int	left_height;
+	int	right_height;
+
+	if ( node == NULL ){
+		*black_height = 1;
+		return;
+	}
+
+	if ( node->left != NULL && ( node->left->parent != node ||
+			tree->compare( node->left, node ) > 0 ) ){
+		(*errors)++;
+	}
+	if ( node->right != NULL && ( node->right->parent != node ||
+			tree->compare( node->right, node ) < 0 ) ){
+		(*errors)++;
+	}
+	if ( node->red && ( IS_RED(node->left) || IS_RED(node->right) ) ){
+		(*errors)++;
+	}
+
+	check_subtree( tree, node->left, &left_height, count, errors );
+	check_subtree( tree, node->right, &right_height, count, errors );
+	if ( left_height != right_height ){
+		(*errors)++;
+	}
+
+	(*count)++;
+	*black_height = left_height + ( node->red ? 0 : 1 );
+}
+
+
+/*! Checks that a tree is a valid red-black tree, in the right order, and
+ *  that its first node and count are right.
+ *
+ * This is O(n), and is meant for debugging.
+ *
+ * @return	Returns the number of problems found (0 if all is well).
+ */
+int rb_check( rb_tree_t *tree )
+{
+	int		errors = 0;
+	int		black_height;
+	unsigned long	count = 0;
+	rb_node_t	*first = tree->root;
+
+	if ( tree->root != NULL ){
+		if ( tree->root->parent != NULL || tree->root->red ){
+			errors++;
+		}
+		while ( first->left != NULL ){
+			first = first->left;
+		}
+	}
+	if ( tree->first != first ){
+		errors++;
+	}
+
+	check_subtree( tree, tree->root, &black_height, &count, &errors );
+	if ( count != tree->count ){
+		errors++;
+	}
+
+	return errors;
+}
@@ -0,0 +1,64 @@
+#ifndef RBTREE_H_GUARD
+#define RBTREE_H_GUARD
+
+/*!
+ * @file	rbtree.h
+ * @brief	Intrusive red-black trees
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ */
+
+
+/*! Red-black tree node.
+ *
+ * The tree does no allocation: each item embeds one of these, and the
+ * tree's compare function gets from a node back to its item. */
+typedef struct rb_node {
+
+	/*! Parent node, or NULL for the root. */
+	struct rb_node		*parent;
+
+	/*! Left (earlier) and right (later) children, or NULL. */
+	struct rb_node		*left;
+	struct rb_node		*right;
+
+	/*! Non-zero if the node is red, zero if it is black. */
+	unsigned char		red;
+
+} rb_node_t;
+
+
+/*! Orders two nodes; returns a negative number, zero, or a positive number
+ *  when \c a sorts before, with, or after \c b. */
+typedef int (*rb_compare_t)( rb_node_t *a, rb_node_t *b );
+
+
+/*! Red-black tree. */
+typedef struct rb_tree {
+
+	/*! Root node, or NULL if the tree is empty. */
+	rb_node_t		*root;
+
+	/*! First (leftmost) node, or NULL if the tree is empty; kept up to
+	 *  date so that rb_first() is constant time. */
+	rb_node_t		*first;
+
+	/*! Number of nodes in the tree. */
+	unsigned long		count;
+
+	/*! Determines the order of the nodes. */
+	rb_compare_t		compare;
+
+} rb_tree_t;
+
+
+void		rb_init		( rb_tree_t *tree, rb_compare_t compare );
+rb_node_t*	rb_insert	( rb_tree_t *tree, rb_node_t *node );
+void		rb_remove	( rb_tree_t *tree, rb_node_t *node );
+rb_node_t*	rb_first	( rb_tree_t *tree );
+rb_node_t*	rb_next		( rb_node_t *node );
+rb_node_t*	rb_prev		( rb_node_t *node );
+int		rb_check	( rb_tree_t *tree );
+
+
+#endif
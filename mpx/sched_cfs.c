@@ -0,0 +1,237 @@
+/*!
+ * @file	sched_cfs.c
+ * @brief	The "cfs" (completely fair) scheduling policy
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ *
+ * Under this policy, every ready process gets a share of the CPU in
+ * proportion to a weight derived from its priority, so low-priority
+ * processes run less often, but never starve.
+ *
+ * Each PCB keeps a virtual runtime (pcb_sched_t::vruntime): the CPU time
+ * it has used, scaled down by its weight.  The ready PCBs are kept in a
+ * red-black tree ordered by virtual runtime, and the one with the least
+ * runs next; picking it is constant time, and inserting or removing a PCB
+ * is O(log n).  The ready queue's list mirrors the tree's order.
+ *
+ * No PCB in the tree is behind min_vruntime, which only ever moves forward,
+ * and only when a PCB is put into the tree; so it still counts the PCB that
+ * was last taken out, which is usually the one that was dispatched.  A PCB
+ * that leaves the tree remembers how far ahead of min_vruntime it was, and
+ * comes back just as far ahead; a process that was away from the ready
+ * queue does not get to make up for lost time, but does not escape time it
+ * owes, either.
+ *
+ * Virtual runtimes are compared modulo 2^32, so they may wrap around as
+ * long as every PCB in the tree stays within 2^31 of min_vruntime.  Lags
+ * are kept within CFS_MAX_LAG to make sure of that.
+ */
+
+
+#include "pcb.h"
+#include "rbtree.h"
+#include <stddef.h>
+
+
+/*! Virtual runtime charged per clock tick to a process with priority 0;
+ *  each 32 steps of priority halve (or double) this. */
+#define CFS_TICK_COST		1024UL
+
+/*! Largest lag (see pcb_sched_t::lag) a PCB may take with it when it leaves
+ *  the tree; about 16 ticks at the lowest priority. */
+#define CFS_MAX_LAG		( 16L * 16L * (long)CFS_TICK_COST )
+
+
+/*! CFS_TICK_COST * 2^(-n/32), for n from 0 through 31. */
+static unsigned int cfs_tick_cost_frac[32] = {
+	1024, 1002, 981, 960, 939, 919, 899, 880,
+	 861,  843, 825, 807, 790, 773, 756, 740,
+	 724,  709, 693, 679, 664, 650, 636, 622,
+	 609,  596, 583, 571, 558, 546, 535, 523
+};
+
+/*! The ready PCBs, by virtual runtime. */
+static rb_tree_t	cfs_tree;
+
+/*! The least virtual runtime in cfs_tree, as of when a PCB was last put
+ *  into it. */
+static unsigned long	cfs_min_vruntime;
+
+
+/*! Gets from a node of cfs_tree to its PCB's pcb_sched_t. */
+#define CFS_SCHED(node) \
+	((pcb_sched_t *)( (char *)(node) - offsetof(pcb_sched_t, tree_node) ))
+
+
+/*! Virtual runtime charged per clock tick at the given priority.
+ *
+ * This is CFS_TICK_COST * 2^(-priority/32): from about 16 times
+ * CFS_TICK_COST at PRIORITY_MIN, down to CFS_TICK_COST/16 at PRIORITY_MAX,
+ * so the highest-priority process gets 256 times the share of the lowest.
+ *
+ * @private
+ */
+static unsigned long cfs_tick_cost( int priority )
+{
+	/* priority + 128 = 32*whole + frac, with whole from 0 to 8. */
+	int	steps = priority - PRIORITY_MIN + 1;
+
+	return ( (unsigned long)cfs_tick_cost_frac[steps % 32] << 4 ) >>
+		( steps / 32 );
+}
+
+
+/*! Orders cfs_tree by virtual runtime (modulo 2^32).
+ *
+ * @private
+ */
+static int cfs_compare( rb_node_t *a, rb_node_t *b )
+{
+	long diff = (long)( CFS_SCHED(a)->vruntime - CFS_SCHED(b)->vruntime );
+
+	return diff < 0 ? -1 : diff > 0 ? 1 : 0;
+}
+
+
+/*! Moves cfs_min_vruntime up to the first PCB's virtual runtime, if that is
+ *  ahead of it.
+ *
+ * @private
+ */
+static void cfs_update_min( void )
+{
+	rb_node_t *first = rb_first( &cfs_tree );
+
+	if ( first != NULL &&
+		(long)( CFS_SCHED(first)->vruntime - cfs_min_vruntime ) > 0 ){
+		cfs_min_vruntime = CFS_SCHED(first)->vruntime;
+	}
+}
+
+
+/*! Puts a PCB whose virtual runtime is set into the tree, and into the
+ *  queue's list just after the PCB before it in the tree.
+ *
+ * @private
+ */
+static void cfs_link( pcb_queue_t *queue, pcb_t *pcb )
+{
+	rb_node_t *before = rb_insert( &cfs_tree, &pcb->sched->tree_node );
+
+	link_queue_node( queue, &pcb->queue_node,
+		before == NULL ? NULL : &CFS_SCHED(before)->pcb->queue_node );
+	cfs_update_min();
+}
+
+
+static int cfs_start( pcb_queue_t *queue )
+{
+	rb_init( &cfs_tree, cfs_compare );
+	cfs_min_vruntime = 0;
+	queue->sort_order = POLICY;
+	queue->prio_index = NULL;
+	return 1;
+}
+
+
+/*! A PCB that has become ready is placed as far ahead of min_vruntime as it
+ *  was when it left.
+ */
+static void cfs_enqueue( pcb_queue_t *queue, pcb_t *pcb )
+{
+	pcb_sched_t *sched = pcb->sched;
+
+	sched->vruntime = cfs_min_vruntime + (unsigned long)sched->lag;
+	cfs_link( queue, pcb );
+}
+
+
+/*! A preempted PCB is placed where it left, plus the virtual runtime it
+ *  used while it ran.
+ */
+static void cfs_requeue( pcb_queue_t *queue, pcb_t *pcb, unsigned int ticks )
+{
+	pcb_sched_t *sched = pcb->sched;
+
+	sched->vruntime = cfs_min_vruntime + (unsigned long)sched->lag +
+		(unsigned long)ticks * cfs_tick_cost( pcb->priority );
+	cfs_link( queue, pcb );
+}
+
+
+/*! The PCB's lag is taken against min_vruntime as it stands, which is not
+ *  moved on until the next PCB is put into the tree; so the lag is never
+ *  negative, and a PCB that was first in line comes back with none.
+ */
+static void cfs_remove( pcb_queue_t *queue, pcb_t *pcb )
+{
+	pcb_sched_t	*sched = pcb->sched;
+	long		 lag;
+
+	rb_remove( &cfs_tree, &sched->tree_node );
+	unlink_queue_node( queue, &pcb->queue_node );
+
+	lag = (long)( sched->vruntime - cfs_min_vruntime );
+	sched->lag = lag > CFS_MAX_LAG ? CFS_MAX_LAG : lag;
+}
+
+
+static pcb_t* cfs_pick_next( pcb_queue_t *queue )
+{
+	rb_node_t *first = rb_first( &cfs_tree );
+
+	return first == NULL ? NULL : CFS_SCHED(first)->pcb;
+}
+
+
+/*! The new priority only changes how fast the PCB's virtual runtime grows
+ *  from now on, so the PCB stays where it is.
+ */
+static void cfs_change_prio( pcb_queue_t *queue, pcb_t *pcb, int priority )
+{
+	pcb->priority = priority;
+}
+
+
+/*! Checks the tree, and that the queue's list is in the same order.
+ */
+static int cfs_check( pcb_queue_t *queue )
+{
+	int			 errors = rb_check( &cfs_tree );
+	rb_node_t		*tree_node = rb_first( &cfs_tree );
+	pcb_queue_node_t	*node;
+
+	foreach_listitem( node, queue ){
+		if ( tree_node == NULL || CFS_SCHED(tree_node)->pcb != node->pcb ){
+			errors++;
+			break;
+		}
+		if ( (long)( CFS_SCHED(tree_node)->vruntime -
+				cfs_min_vruntime ) < 0 ){
+			errors++;
+		}
+		tree_node = rb_next( tree_node );
+	}
+	if ( cfs_tree.count != queue->length ){
+		errors++;
+	}
+
+	return errors;
+}
+
+
+/*! The "cfs" scheduling policy. */
+sched_policy_t sched_cfs = {
+	"cfs",
+	"completely fair: CPU shares weighted by priority",
+	cfs_start,
+	cfs_enqueue,
+	cfs_requeue,
+	cfs_remove,
+	cfs_pick_next,
+	cfs_change_prio,
+	cfs_check,
+	NULL,
+	NULL,
+	NULL
+};
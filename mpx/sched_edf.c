@@ -0,0 +1,380 @@
+/*!
+ * @file	sched_edf.c
+ * @brief	Earliest-deadline-first scheduling of real-time processes
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ *
+ * A real-time process (see set_pcb_realtime()) has a period, a budget and
+ * a deadline, all in clock ticks.  Each time it becomes ready, it starts a
+ * job, which needs up to \c budget ticks of CPU time, and is due \c deadline
+ * ticks after it is released; the job ends when the process blocks.  Jobs
+ * are released at least a period apart, as for a sporadic task: a process
+ * that becomes ready again sooner goes on with the job it had, if that has
+ * budget left.
+ *
+ * Ready real-time processes are kept in a queue of their own, which is
+ * always dispatched before the ready queue, in order of their jobs'
+ * deadlines.  The queue is kept in a red-black tree, ordered by deadline,
+ * so picking the next process is constant time, and inserting or removing
+ * one is O(log n); the queue's list mirrors the tree's order.
+ *
+ * As long as the total load (the sum of budget / deadline) is at most 1,
+ * this meets every deadline; set_pcb_realtime() only admits processes
+ * while the total stays within RT_LOAD_BOUND.  A process whose job has
+ * used up its budget, and whose next job is not yet due, is throttled: it
+ * waits in the ready queue, as an ordinary process, until it goes through
+ * the scheduler again at or after its next release (see update_realtime()).
+ * So a process that takes more than it asked for gets no more than its
+ * budget ahead of the other processes, and only delays itself.
+ *
+ * A job that ends (or is preempted) after its deadline counts as a miss;
+ * see get_realtime_stats().
+ */
+
+
+#include "pcb.h"
+#include "rbtree.h"
+#include <stddef.h>
+
+
+/*! The ready real-time PCBs, by deadline. */
+static rb_tree_t	edf_tree;
+
+/*! Totals; see get_realtime_stats(). */
+static pcb_rt_stats_t	edf_stats;
+
+
+/*! Gets from a node of edf_tree to its PCB's pcb_sched_t. */
+#define EDF_SCHED(node) \
+	((pcb_sched_t *)( (char *)(node) - offsetof(pcb_sched_t, tree_node) ))
+
+
+/*! Orders edf_tree by deadline (modulo 2^32).
+ *
+ * @private
+ */
+static int edf_compare( rb_node_t *a, rb_node_t *b )
+{
+	long diff = (long)( EDF_SCHED(a)->rt_abs_deadline -
+		EDF_SCHED(b)->rt_abs_deadline );
+
+	return diff < 0 ? -1 : diff > 0 ? 1 : 0;
+}
+
+
+/*! A real-time process's load (see RT_LOAD_SCALE), rounded up.
+ *
+ * @private
+ */
+static unsigned int edf_load_of( unsigned int budget, unsigned int deadline )
+{
+	return (unsigned int)( ( (unsigned long)budget * RT_LOAD_SCALE +
+		deadline - 1 ) / deadline );
+}
+
+
+/*! Charges the current job for the ticks its process ran.
+ *
+ * @private
+ */
+static void edf_charge( pcb_sched_t *sched, unsigned int ticks )
+{
+	sched->rt_left -= ticks < sched->rt_left ? ticks : sched->rt_left;
+}
+
+
+/*! Counts a miss, if the current job is late and has not already been
+ *  counted.
+ *
+ * @private
+ */
+static void edf_check_deadline( pcb_sched_t *sched )
+{
+	if ( ! sched->rt_missed && (long)( get_sched_clock() -
+			( sched->rt_release + sched->rt_deadline ) ) > 0 ){
+		sched->rt_missed = 1;
+		sched->rt_misses++;
+		edf_stats.misses++;
+	}
+}
+
+
+/*! Starts a new job, released at the given time.
+ *
+ * @private
+ */
+static void edf_release( pcb_sched_t *sched, unsigned long release )
+{
+	sched->rt_missed	= 0;
+	sched->rt_release	= release;
+	sched->rt_abs_deadline	= release + sched->rt_deadline;
+	sched->rt_left		= sched->rt_budget;
+	sched->rt_jobs++;
+	edf_stats.jobs++;
+}
+
+
+/*! Puts a PCB whose deadline is set into the tree, and into the queue's
+ *  list just after the PCB before it in the tree.
+ *
+ * @private
+ */
+static void edf_link( pcb_queue_t *queue, pcb_t *pcb )
+{
+	rb_node_t *before = rb_insert( &edf_tree, &pcb->sched->tree_node );
+
+	link_queue_node( queue, &pcb->queue_node,
+		before == NULL ? NULL : &EDF_SCHED(before)->pcb->queue_node );
+}
+
+
+static int edf_start( pcb_queue_t *queue )
+{
+	rb_init( &edf_tree, edf_compare );
+	queue->sort_order = POLICY;
+	queue->prio_index = NULL;
+	return 1;
+}
+
+
+/*! update_realtime() has already started the PCB's job, if it needed one.
+ */
+static void edf_enqueue( pcb_queue_t *queue, pcb_t *pcb )
+{
+	edf_link( queue, pcb );
+}
+
+
+/*! update_realtime() has already charged the PCB's job for the ticks it
+ *  ran.
+ */
+static void edf_requeue( pcb_queue_t *queue, pcb_t *pcb, unsigned int ticks )
+{
+	edf_link( queue, pcb );
+}
+
+
+static void edf_remove( pcb_queue_t *queue, pcb_t *pcb )
+{
+	rb_remove( &edf_tree, &pcb->sched->tree_node );
+	unlink_queue_node( queue, &pcb->queue_node );
+}
+
+
+static pcb_t* edf_pick_next( pcb_queue_t *queue )
+{
+	rb_node_t *first = rb_first( &edf_tree );
+
+	return first == NULL ? NULL : EDF_SCHED(first)->pcb;
+}
+
+
+/*! Priority plays no part in the order of real-time processes. */
+static void edf_change_prio( pcb_queue_t *queue, pcb_t *pcb, int priority )
+{
+	pcb->priority = priority;
+}
+
+
+/*! Checks the tree, and that the queue's list is in the same order; and
+ *  that every PCB in it has a job under way that has been released, has
+ *  budget left, and is due when its release says it is.
+ */
+static int edf_check( pcb_queue_t *queue )
+{
+	int			 errors = rb_check( &edf_tree );
+	rb_node_t		*tree_node = rb_first( &edf_tree );
+	pcb_queue_node_t	*node;
+	pcb_sched_t		*sched;
+
+	foreach_listitem( node, queue ){
+		if ( tree_node == NULL || EDF_SCHED(tree_node)->pcb != node->pcb ){
+			errors++;
+			break;
+		}
+		sched = node->pcb->sched;
+		if ( node->pcb->class != REALTIME || ! sched->rt_active ||
+				sched->rt_throttled ){
+			errors++;
+		}
+		if ( sched->rt_left == 0 || sched->rt_left > sched->rt_budget ||
+				(long)( get_sched_clock() - sched->rt_release ) < 0 ||
+				sched->rt_abs_deadline !=
+					sched->rt_release + sched->rt_deadline ){
+			errors++;
+		}
+		tree_node = rb_next( tree_node );
+	}
+	if ( edf_tree.count != queue->length ){
+		errors++;
+	}
+
+	return errors;
+}
+
+
+/*! A process that blocks has finished its job, which is charged for the
+ *  ticks it ran, unless it ran them throttled.
+ */
+static void edf_block( pcb_t *pcb, unsigned int ticks )
+{
+	if ( ! pcb->sched->rt_throttled ){
+		edf_charge( pcb->sched, ticks );
+		edf_check_deadline( pcb->sched );
+	}
+	pcb->sched->rt_active = 0;
+}
+
+
+/*! What is left of the job's budget.
+ */
+static unsigned int edf_time_slice( pcb_t *pcb )
+{
+	return pcb->sched->rt_active ? pcb->sched->rt_left : pcb->sched->rt_budget;
+}
+
+
+/*! Runs the real-time queue (see get_realtime_queue()); it is not one of
+ *  sched_policies[], and cannot be put in charge of the ready queue. */
+sched_policy_t sched_edf = {
+	"edf",
+	"real-time processes: earliest deadline first",
+	edf_start,
+	edf_enqueue,
+	edf_requeue,
+	edf_remove,
+	edf_pick_next,
+	edf_change_prio,
+	edf_check,
+	edf_block,
+	NULL,
+	edf_time_slice
+};
+
+
+/*! Makes a process a real-time process, or changes its period, budget and
+ *  deadline, subject to admission control.
+ *
+ * The process's class becomes REALTIME.  It is admitted only if the total
+ * load of the real-time processes (each one's budget / deadline) would stay
+ * within RT_LOAD_BOUND.  Its next job starts when it next becomes ready,
+ * but is released no sooner than a period after its last one.
+ *
+ * @return	Returns 1 if the process was admitted; 0 if the arguments are
+ *		invalid, or the PCB is enqueued; or -1 if it would take the
+ *		load over RT_LOAD_BOUND.  Nothing changes unless it returns 1.
+ */
+int set_pcb_realtime(
+	/*! The PCB; it must not be enqueued. */
+	pcb_t		*pcb,
+	/*! The least time between the starts of two jobs, in clock ticks;
+	 *  at most RT_MAX_TICKS. */
+	unsigned int	 period,
+	/*! CPU time each job needs, in clock ticks; at least 1. */
+	unsigned int	 budget,
+	/*! How long after it starts each job is due, in clock ticks; from
+	 *  budget to period, or 0 for the period. */
+	unsigned int	 deadline
+)
+{
+	pcb_sched_t	*sched;
+	unsigned int	 load;
+	unsigned int	 old_load = 0;
+
+	if ( deadline == 0 ){
+		deadline = period;
+	}
+	if ( pcb == NULL || pcb->queue_node.queue != NULL || budget == 0 ||
+			budget > deadline || deadline > period ||
+			period > RT_MAX_TICKS ){
+		return 0;
+	}
+
+	sched = pcb->sched;
+	load = edf_load_of( budget, deadline );
+	if ( pcb->class == REALTIME ){
+		old_load = edf_load_of( sched->rt_budget, sched->rt_deadline );
+	}
+	if ( edf_stats.load - old_load + load > RT_LOAD_BOUND ){
+		return -1;
+	}
+
+	if ( pcb->class != REALTIME ){
+		pcb->class = REALTIME;
+		sched->rt_active = 0;
+		sched->rt_throttled = 0;
+		sched->rt_jobs = 0;
+		sched->rt_misses = 0;
+		edf_stats.processes++;
+	}
+	edf_stats.load = edf_stats.load - old_load + load;
+
+	sched->rt_period	= period;
+	sched->rt_budget	= budget;
+	sched->rt_deadline	= deadline;
+
+	return 1;
+}
+
+
+/*! Brings a ready real-time process's job up to date, before the process
+ *  is put in a queue; insert_pcb() and preempt_pcb() call this, and its
+ *  rt_throttled member then says which queue it goes in.
+ *
+ * If the process ran its job for some ticks, the job is charged for them.
+ * A process that has just become ready starts a new job, unless its last
+ * one was released less than a period ago; it then goes on with that one.
+ * A job that has used up its budget gets no more CPU time as a real-time
+ * job: the process is throttled, and goes in the ready queue, until it is
+ * put in a queue again at or after its next release (its last release plus
+ * a period), which starts its next job.
+ */
+void update_realtime(
+	/*! The PCB; it must be ready, real-time, and in no queue. */
+	pcb_t		*pcb,
+	/*! How long it ran for since it was dispatched, in clock ticks, or 0
+	 *  if it was not. */
+	unsigned int	 ticks
+)
+{
+	pcb_sched_t	*sched = pcb->sched;
+	unsigned long	 now = get_sched_clock();
+	/* The earliest the next job may be released. */
+	unsigned long	 next = sched->rt_release + sched->rt_period;
+
+	if ( ticks > 0 && sched->rt_active && ! sched->rt_throttled ){
+		edf_charge( sched, ticks );
+		edf_check_deadline( sched );
+	}
+
+	if ( ! sched->rt_active ){
+		if ( sched->rt_jobs == 0 || (long)( now - next ) >= 0 ){
+			edf_release( sched, now );
+		}
+		sched->rt_active = 1;
+	} else if ( sched->rt_left == 0 && (long)( now - next ) >= 0 ){
+		edf_release( sched, now );
+	}
+
+	sched->rt_throttled = sched->rt_left == 0;
+}
+
+
+/*! Takes a real-time process's load off the books, because it is going
+ *  away; free_pcb() calls this. */
+void release_realtime( pcb_t *pcb )
+{
+	edf_stats.load -= edf_load_of( pcb->sched->rt_budget,
+		pcb->sched->rt_deadline );
+	edf_stats.processes--;
+}
+
+
+/*! Reports totals for the real-time processes. */
+void get_realtime_stats(
+	/*! [out] Receives a copy of the totals. */
+	pcb_rt_stats_t *stats
+)
+{
+	*stats = edf_stats;
+}
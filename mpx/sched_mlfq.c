@@ -0,0 +1,362 @@
+/*!
+ * @file	sched_mlfq.c
+ * @brief	The "mlfq" (multi-level feedback queue) scheduling policy
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ *
+ * Under this policy, a process's place in line depends on how it has been
+ * behaving, rather than on its priority (which is ignored):
+ *
+ * <ul>
+ *	<li> There are several levels, each with its own quantum.  A process
+ *		at a higher level always runs before one at a lower level, and
+ *		processes at the same level take turns.
+ *	<li> A new process starts at the top level (level 0).
+ *	<li> A process that has run for its level's whole quantum (over one
+ *		or more turns) moves down a level, where the quantum is longer.
+ *	<li> A process that blocks moves up a level.
+ *	<li> Every so often (the aging period), every process goes back to
+ *		the top level, so that nothing starves.
+ * </ul>
+ *
+ * So processes that only run for a little while between waits for I/O
+ * stay near the top, and are dispatched quickly when they wake; CPU-bound
+ * processes sink, and share what is left in long quanta.
+ *
+ * The ready queue's list is made up of back-to-back FIFO runs, one per
+ * level, from the top down, just like a PRIORITY queue; so picking the next
+ * process and inserting or removing one take constant time.  Aging takes
+ * time in proportion to the number of levels, not processes: a PCB's level
+ * is only good for the aging period it was set in (pcb_sched_t::epoch), and
+ * otherwise is taken to be 0.
+ */
+
+
+#include "pcb.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/*! Greatest number of levels. */
+#define MLFQ_MAX_LEVELS		8
+
+/*! Greatest quantum, or aging period, that may be set; in clock ticks. */
+#define MLFQ_MAX_TICKS		9999
+
+
+/*! Number of levels in use. */
+static int		mlfq_levels = 4;
+
+/*! Quantum of each level, in clock ticks. */
+static unsigned int	mlfq_quanta[MLFQ_MAX_LEVELS] = {
+	1, 2, 4, 8, 16, 32, 64, 128
+};
+
+/*! Clock ticks between agings, or 0 for never. */
+static unsigned int	mlfq_aging_period = 1000;
+
+/*! Clock ticks run since the last aging. */
+static unsigned int	mlfq_clock;
+
+/*! Current aging period; see pcb_sched_t::epoch. */
+static unsigned long	mlfq_epoch;
+
+/*! Last node of each level's run in the ready queue, or NULL. */
+static pcb_queue_node_t	*mlfq_tail[MLFQ_MAX_LEVELS];
+
+/*! The policy's description, which shows the settings. */
+static char		mlfq_description[96] =
+	"feedback queues; quanta 1/2/4/8, aging every 1000 ticks";
+
+
+/*! The level of a PCB, as of the current aging period. */
+#define MLFQ_LEVEL(sched) \
+	( (sched)->epoch == mlfq_epoch ? (int)(sched)->level : 0 )
+
+
+/*! Starts a new aging period, which moves every PCB to the top level.
+ *
+ * The ready queue's runs all simply become part of level 0's.
+ *
+ * @private
+ */
+static void mlfq_age( pcb_queue_t *queue )
+{
+	int level;
+
+	mlfq_epoch++;
+	mlfq_clock = 0;
+
+	for ( level = 0; level < MLFQ_MAX_LEVELS; level++ ){
+		mlfq_tail[level] = NULL;
+	}
+	mlfq_tail[0] = queue->tail;
+}
+
+
+/*! Sets a PCB's level (for the current aging period), and links it in at
+ *  the end of that level's run.
+ *
+ * @private
+ */
+static void mlfq_link( pcb_queue_t *queue, pcb_t *pcb, int level )
+{
+	/* The level whose run the PCB goes after. */
+	int higher_level;
+
+	pcb->sched->level = (unsigned char)level;
+	pcb->sched->epoch = mlfq_epoch;
+
+	for ( higher_level = level; higher_level >= 0; higher_level-- ){
+		if ( mlfq_tail[higher_level] != NULL ){
+			break;
+		}
+	}
+
+	link_queue_node( queue, &pcb->queue_node,
+		higher_level < 0 ? NULL : mlfq_tail[higher_level] );
+	mlfq_tail[level] = &pcb->queue_node;
+}
+
+
+static int mlfq_start( pcb_queue_t *queue )
+{
+	mlfq_age( queue );
+	queue->sort_order = POLICY;
+	queue->prio_index = NULL;
+	return 1;
+}
+
+
+/*! A PCB that has become ready joins its level (the top level, if it is
+ *  new, or it has been away since the last aging).
+ */
+static void mlfq_enqueue( pcb_queue_t *queue, pcb_t *pcb )
+{
+	if ( pcb->sched->epoch != mlfq_epoch ){
+		pcb->sched->used = 0;
+	}
+	mlfq_link( queue, pcb, MLFQ_LEVEL(pcb->sched) );
+}
+
+
+/*! A preempted PCB moves down a level if it has now used up its quantum,
+ *  and otherwise goes to the back of its level.
+ */
+static void mlfq_requeue( pcb_queue_t *queue, pcb_t *pcb, unsigned int ticks )
+{
+	pcb_sched_t	*sched = pcb->sched;
+	int		 level;
+
+	mlfq_clock += ticks;
+	if ( mlfq_aging_period != 0 && mlfq_clock >= mlfq_aging_period ){
+		mlfq_age( queue );
+	}
+
+	if ( sched->epoch != mlfq_epoch ){
+		sched->used = 0;
+		mlfq_link( queue, pcb, 0 );
+		return;
+	}
+
+	level = sched->level;
+	sched->used += ticks;
+	if ( sched->used >= mlfq_quanta[level] ){
+		sched->used = 0;
+		if ( level < mlfq_levels - 1 ){
+			level++;
+		}
+	}
+	mlfq_link( queue, pcb, level );
+}
+
+
+static void mlfq_remove( pcb_queue_t *queue, pcb_t *pcb )
+{
+	pcb_queue_node_t	*node = &pcb->queue_node;
+	pcb_queue_node_t	*prev = node->prev;
+	int			 level = MLFQ_LEVEL(pcb->sched);
+
+	if ( mlfq_tail[level] == node ){
+		if ( prev != NULL && MLFQ_LEVEL(prev->pcb->sched) == level ){
+			mlfq_tail[level] = prev;
+		} else {
+			mlfq_tail[level] = NULL;
+		}
+	}
+
+	unlink_queue_node( queue, node );
+}
+
+
+static pcb_t* mlfq_pick_next( pcb_queue_t *queue )
+{
+	return queue->head == NULL ? NULL : queue->head->pcb;
+}
+
+
+/*! Priority plays no part in this policy. */
+static void mlfq_change_prio( pcb_queue_t *queue, pcb_t *pcb, int priority )
+{
+	pcb->priority = priority;
+}
+
+
+/*! Checks that the queue's list is made up of one run per level, in order,
+ *  and that each run's recorded tail is right.
+ */
+static int mlfq_check( pcb_queue_t *queue )
+{
+	int			 errors = 0;
+	int			 level;
+	int			 next_level;
+	pcb_queue_node_t	*node;
+
+	foreach_listitem( node, queue ){
+		level = MLFQ_LEVEL(node->pcb->sched);
+		if ( level >= mlfq_levels ){
+			errors++;
+			continue;
+		}
+		if ( node->next == NULL ){
+			next_level = MLFQ_MAX_LEVELS;
+		} else {
+			next_level = MLFQ_LEVEL(node->next->pcb->sched);
+		}
+		if ( next_level < level ){
+			errors++;
+		}
+		if ( ( mlfq_tail[level] == node ) != ( next_level != level ) ){
+			errors++;
+		}
+	}
+
+	for ( level = 0; level < MLFQ_MAX_LEVELS; level++ ){
+		node = mlfq_tail[level];
+		if ( node != NULL && ( node->queue != queue ||
+				MLFQ_LEVEL(node->pcb->sched) != level ) ){
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+
+/*! A PCB that blocks moves up a level, and starts its quantum afresh. */
+static void mlfq_block( pcb_t *pcb, unsigned int ticks )
+{
+	int level = MLFQ_LEVEL(pcb->sched);
+
+	pcb->sched->level = (unsigned char)( level > 0 ? level - 1 : 0 );
+	pcb->sched->epoch = mlfq_epoch;
+	pcb->sched->used = 0;
+}
+
+
+/*! Reads one setting, a number of clock ticks from \c low to MLFQ_MAX_TICKS.
+ *
+ * @return	Returns the number, or -1 if it is invalid.
+ *
+ * @private
+ */
+static long mlfq_parse_ticks( char *arg, long low )
+{
+	char	*end;
+	long	 ticks = strtol( arg, &end, 10 );
+
+	if ( end == arg || *end != '\0' || ticks < low ||
+			ticks > MLFQ_MAX_TICKS ){
+		return -1;
+	}
+	return ticks;
+}
+
+
+/*! Takes the quantum of each level, from the top down (which also sets the
+ *  number of levels), and/or "-a" followed by the aging period (0 for
+ *  never).  Every process goes back to the top level.
+ */
+static int mlfq_tune( pcb_queue_t *queue, int argc, char *argv[] )
+{
+	unsigned int	quanta[MLFQ_MAX_LEVELS];
+	int		levels = 0;
+	long		aging_period = mlfq_aging_period;
+	long		ticks;
+	int		i;
+	char		*out;
+
+	for ( i = 0; i < argc; i++ ){
+		if ( strcmp( argv[i], "-a" ) == 0 && i + 1 < argc ){
+			aging_period = mlfq_parse_ticks( argv[++i], 0 );
+			if ( aging_period < 0 ){
+				return 0;
+			}
+			continue;
+		}
+		ticks = mlfq_parse_ticks( argv[i], 1 );
+		if ( ticks < 0 || levels == MLFQ_MAX_LEVELS ){
+			return 0;
+		}
+		quanta[levels++] = (unsigned int)ticks;
+	}
+
+	if ( queue == NULL ){
+		return 1;
+	}
+
+	if ( levels > 0 ){
+		mlfq_levels = levels;
+		for ( i = 0; i < levels; i++ ){
+			mlfq_quanta[i] = quanta[i];
+		}
+	}
+	mlfq_aging_period = (unsigned int)aging_period;
+	mlfq_age( queue );
+
+	out = mlfq_description;
+	out += sprintf( out, "feedback queues; quanta" );
+	for ( i = 0; i < mlfq_levels; i++ ){
+		out += sprintf( out, "%c%u", i == 0 ? ' ' : '/',
+			mlfq_quanta[i] );
+	}
+	if ( mlfq_aging_period == 0 ){
+		sprintf( out, ", no aging" );
+	} else {
+		sprintf( out, ", aging every %u ticks", mlfq_aging_period );
+	}
+
+	return 1;
+}
+
+
+/*! What is left of the PCB's quantum. */
+static unsigned int mlfq_time_slice( pcb_t *pcb )
+{
+	pcb_sched_t	*sched = pcb->sched;
+	unsigned int	 quantum;
+
+	if ( sched->epoch != mlfq_epoch ){
+		return mlfq_quanta[0];
+	}
+	quantum = mlfq_quanta[sched->level];
+	return sched->used < quantum ? quantum - sched->used : 1;
+}
+
+
+/*! The "mlfq" scheduling policy. */
+sched_policy_t sched_mlfq = {
+	"mlfq",
+	mlfq_description,
+	mlfq_start,
+	mlfq_enqueue,
+	mlfq_requeue,
+	mlfq_remove,
+	mlfq_pick_next,
+	mlfq_change_prio,
+	mlfq_check,
+	mlfq_block,
+	mlfq_tune,
+	mlfq_time_slice
+};
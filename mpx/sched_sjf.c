@@ -0,0 +1,307 @@
+/*!
+ * @file	sched_sjf.c
+ * @brief	The "sjf" (shortest job first) scheduling policy
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ *
+ * Under this policy, the process expected to need the CPU for the least
+ * time runs first, which gives the least mean turnaround time; priority is
+ * ignored, and so is fairness: a long burst waits for as long as shorter
+ * ones keep coming.
+ *
+ * How long a process will run before it next blocks (its next CPU burst)
+ * is predicted from its past bursts, by an exponentially weighted average
+ * (pcb_sched_t::burst_avg): each time the process blocks, the burst it
+ * just finished is given a weight of alpha, and the old average the rest.
+ * A process with no bursts yet is predicted SJF_FIRST_BURST.  A burst that
+ * runs past its prediction is taken to have half its prediction left, plus
+ * as long again as it has overrun by; so one that is nearly done still
+ * finishes soon, but a process whose behaviour has changed slips back in
+ * line, rather than holding on to the CPU.
+ *
+ * There are two modes.  In "srtf" (shortest remaining time first, the
+ * default), a process is preempted after SCHED_TIME_SLICE, and placed by
+ * the time its burst is predicted to have left; so a shorter job that has
+ * become ready in the meantime gets the CPU next.  In "sjf", a process
+ * runs until it blocks, and is placed by its whole predicted burst.
+ *
+ * The ready PCBs are kept in a red-black tree by prediction (ties in the
+ * order they arrived), so picking the next one is constant time, and
+ * inserting or removing one is O(log n); the ready queue's list mirrors the
+ * tree's order.  Bursts are only measured while this policy is in charge.
+ */
+
+
+#include "pcb.h"
+#include "rbtree.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/*! Fractions of a clock tick that predictions are kept in. */
+#define SJF_SCALE		16UL
+
+/*! Predicted burst of a process that has not blocked yet, in clock ticks. */
+#define SJF_FIRST_BURST		SCHED_TIME_SLICE
+
+/*! Longest burst that is measured or predicted, in clock ticks; anything
+ *  longer counts as this long. */
+#define SJF_MAX_BURST		32767U
+
+
+/*! The ready PCBs, by prediction. */
+static rb_tree_t	sjf_tree;
+
+/*! Non-zero in "srtf" mode, 0 in "sjf" mode. */
+static int		sjf_preemptive = 1;
+
+/*! Weight of the latest burst in the average, in percent. */
+static unsigned int	sjf_alpha = 50;
+
+/*! The policy's description, which shows the settings. */
+static char		sjf_description[64] =
+	"shortest remaining time first; alpha 50%";
+
+
+/*! Gets from a node of sjf_tree to its PCB's pcb_sched_t. */
+#define SJF_SCHED(node) \
+	((pcb_sched_t *)( (char *)(node) - offsetof(pcb_sched_t, tree_node) ))
+
+
+/*! Orders sjf_tree by prediction.
+ *
+ * @private
+ */
+static int sjf_compare( rb_node_t *a, rb_node_t *b )
+{
+	unsigned long key_a = SJF_SCHED(a)->burst_key;
+	unsigned long key_b = SJF_SCHED(b)->burst_key;
+
+	return key_a < key_b ? -1 : key_a > key_b ? 1 : 0;
+}
+
+
+/*! Predicted length of a PCB's current burst, all told, in 1/SJF_SCALE
+ *  ticks.
+ *
+ * @private
+ */
+static unsigned long sjf_predict( pcb_sched_t *sched )
+{
+	unsigned long predict = sched->burst_avg;
+	unsigned long run = sched->burst_run * SJF_SCALE;
+
+	if ( predict == 0 ){
+		predict = SJF_FIRST_BURST * SJF_SCALE;
+	}
+	if ( run >= predict ){
+		predict = 2 * run - predict / 2;
+	}
+	return predict;
+}
+
+
+/*! Sets a PCB's key from its prediction, and puts it into the tree, and
+ *  into the queue's list just after the PCB before it in the tree.
+ *
+ * @private
+ */
+static void sjf_link( pcb_queue_t *queue, pcb_t *pcb )
+{
+	pcb_sched_t	*sched = pcb->sched;
+	rb_node_t	*before;
+
+	sched->burst_key = sjf_predict( sched );
+	if ( sjf_preemptive ){
+		sched->burst_key -= sched->burst_run * SJF_SCALE;
+	}
+
+	before = rb_insert( &sjf_tree, &sched->tree_node );
+	link_queue_node( queue, &pcb->queue_node,
+		before == NULL ? NULL : &SJF_SCHED(before)->pcb->queue_node );
+}
+
+
+static int sjf_start( pcb_queue_t *queue )
+{
+	rb_init( &sjf_tree, sjf_compare );
+	queue->sort_order = POLICY;
+	queue->prio_index = NULL;
+	return 1;
+}
+
+
+/*! A PCB that has become ready is placed by its prediction; if it was
+ *  suspended in the middle of a burst, the burst goes on.
+ */
+static void sjf_enqueue( pcb_queue_t *queue, pcb_t *pcb )
+{
+	sjf_link( queue, pcb );
+}
+
+
+/*! A preempted PCB's burst goes on; the ticks it ran count toward it, and
+ *  it is placed by what is predicted to be left.
+ */
+static void sjf_requeue( pcb_queue_t *queue, pcb_t *pcb, unsigned int ticks )
+{
+	pcb_sched_t *sched = pcb->sched;
+
+	sched->burst_run = ticks < SJF_MAX_BURST - sched->burst_run ?
+		sched->burst_run + ticks : SJF_MAX_BURST;
+	sjf_link( queue, pcb );
+}
+
+
+static void sjf_remove( pcb_queue_t *queue, pcb_t *pcb )
+{
+	rb_remove( &sjf_tree, &pcb->sched->tree_node );
+	unlink_queue_node( queue, &pcb->queue_node );
+}
+
+
+static pcb_t* sjf_pick_next( pcb_queue_t *queue )
+{
+	rb_node_t *first = rb_first( &sjf_tree );
+
+	return first == NULL ? NULL : SJF_SCHED(first)->pcb;
+}
+
+
+/*! Priority plays no part in this policy. */
+static void sjf_change_prio( pcb_queue_t *queue, pcb_t *pcb, int priority )
+{
+	pcb->priority = priority;
+}
+
+
+/*! Checks the tree, and that the queue's list is in the same order.
+ */
+static int sjf_check( pcb_queue_t *queue )
+{
+	int			 errors = rb_check( &sjf_tree );
+	rb_node_t		*tree_node = rb_first( &sjf_tree );
+	pcb_queue_node_t	*node;
+
+	foreach_listitem( node, queue ){
+		if ( tree_node == NULL || SJF_SCHED(tree_node)->pcb != node->pcb ){
+			errors++;
+			break;
+		}
+		tree_node = rb_next( tree_node );
+	}
+	if ( sjf_tree.count != queue->length ){
+		errors++;
+	}
+
+	return errors;
+}
+
+
+/*! A PCB that blocks has finished its burst, which goes into its average.
+ */
+static void sjf_block( pcb_t *pcb, unsigned int ticks )
+{
+	pcb_sched_t	*sched = pcb->sched;
+	unsigned long	 burst;
+
+	burst = ticks < SJF_MAX_BURST - sched->burst_run ?
+		sched->burst_run + ticks : SJF_MAX_BURST;
+	burst *= SJF_SCALE;
+
+	if ( sched->burst_avg == 0 ){
+		sched->burst_avg = burst;
+	} else {
+		sched->burst_avg = ( sjf_alpha * burst +
+			( 100 - sjf_alpha ) * sched->burst_avg ) / 100;
+	}
+	if ( sched->burst_avg == 0 ){
+		/* 0 means no bursts yet. */
+		sched->burst_avg = 1;
+	}
+	sched->burst_run = 0;
+}
+
+
+/*! Takes "sjf" or "srtf" for the mode, and/or "-a" followed by alpha, the
+ *  weight of the latest burst in the average, in percent (1 to 100).  The
+ *  ready processes keep their places until they next run.
+ */
+static int sjf_tune( pcb_queue_t *queue, int argc, char *argv[] )
+{
+	int	preemptive = sjf_preemptive;
+	long	alpha = sjf_alpha;
+	char	*end;
+	int	i;
+
+	for ( i = 0; i < argc; i++ ){
+		if ( strcmp( argv[i], "-a" ) == 0 && i + 1 < argc ){
+			i++;
+			alpha = strtol( argv[i], &end, 10 );
+			if ( end == argv[i] || *end != '\0' || alpha < 1 ||
+					alpha > 100 ){
+				return 0;
+			}
+		} else if ( strcmp( argv[i], "sjf" ) == 0 ){
+			preemptive = 0;
+		} else if ( strcmp( argv[i], "srtf" ) == 0 ){
+			preemptive = 1;
+		} else {
+			return 0;
+		}
+	}
+
+	if ( queue == NULL ){
+		return 1;
+	}
+
+	sjf_preemptive = preemptive;
+	sjf_alpha = (unsigned int)alpha;
+	sprintf( sjf_description, "%s; alpha %u%%",
+		sjf_preemptive ? "shortest remaining time first"
+			: "shortest job first, run until blocked",
+		sjf_alpha );
+
+	return 1;
+}
+
+
+/*! SCHED_TIME_SLICE in "srtf" mode; in "sjf" mode, as long as a burst may
+ *  be. */
+static unsigned int sjf_time_slice( pcb_t *pcb )
+{
+	return sjf_preemptive ? SCHED_TIME_SLICE : SJF_MAX_BURST;
+}
+
+
+/*! The "sjf" scheduling policy. */
+sched_policy_t sched_sjf = {
+	"sjf",
+	sjf_description,
+	sjf_start,
+	sjf_enqueue,
+	sjf_requeue,
+	sjf_remove,
+	sjf_pick_next,
+	sjf_change_prio,
+	sjf_check,
+	sjf_block,
+	sjf_tune,
+	sjf_time_slice
+};
+
+
+/*! Predicts how long a process's current (or next) CPU burst will be, all
+ *  told, as the "sjf" policy does.
+ *
+ * @return	Returns the prediction, in tenths of a clock tick.
+ */
+unsigned long get_burst_estimate(
+	/*! The PCB. */
+	pcb_t *pcb
+)
+{
+	return ( sjf_predict( pcb->sched ) * 10 + SJF_SCALE / 2 ) / SJF_SCALE;
+}
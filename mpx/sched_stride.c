@@ -0,0 +1,363 @@
+/*!
+ * @file	sched_stride.c
+ * @brief	The "stride" (hierarchical proportional-share) scheduling policy
+ * @author	Paul Prince <paul@littlebluetech.com>
+ * @date	2011
+ *
+ * Under this policy, the CPU is shared among process groups (see
+ * set_pcb_group()) in proportion to their weights, however many processes
+ * each group has; within a group, the ready processes share the group's
+ * time equally (their priorities are ignored).
+ *
+ * This is stride scheduling, on two levels.  Each group has a pass, which
+ * goes up by STRIDE_ONE / weight for each clock tick its processes run, and
+ * each PCB has a pass within its group, which goes up by STRIDE_ONE for each
+ * tick it runs.  The group with the least pass runs next, and within it the
+ * PCB with the least pass.  Groups with ready processes are kept in a
+ * red-black tree by pass, and each group's ready PCBs in a tree of their
+ * own, so picking the next PCB is constant time, and inserting or removing
+ * one is O(log groups + log processes).
+ *
+ * The ready queue's list is made up of back-to-back runs, one per group, in
+ * the order of the groups' tree; each run is in the order of its group's
+ * tree.  When a group's pass changes, its whole run is moved at once.
+ *
+ * As in the "cfs" policy, the least pass in each tree only ever moves
+ * forward, and a group (or PCB) that leaves its tree remembers how far
+ * ahead of it or behind it it was (its remain), within STRIDE_MAX_REMAIN;
+ * it comes back just as far ahead, but is not given credit for the time it
+ * was away.  Passes are compared modulo 2^32.
+ */
+
+
+#include "pcb.h"
+#include "rbtree.h"
+#include <stddef.h>
+
+
+/*! Pass a PCB is charged per clock tick; a group is charged this divided
+ *  by its weight. */
+#define STRIDE_ONE		( 1UL << 20 )
+
+/*! Largest remain (see pcb_group_t::remain) a group or PCB may take with it
+ *  when it leaves its tree, and largest pass it may be charged at once. */
+#define STRIDE_MAX_REMAIN	( 64L * (long)STRIDE_ONE )
+
+
+/*! The groups with ready PCBs, by pass. */
+static rb_tree_t	stride_groups;
+
+/*! The least pass in stride_groups (or the last there was). */
+static unsigned long	stride_min_pass;
+
+
+/*! Gets from a node of stride_groups to its group. */
+#define STRIDE_GROUP(node) \
+	((pcb_group_t *)( (char *)(node) - offsetof(pcb_group_t, tree_node) ))
+
+/*! Gets from a node of a group's tree to its PCB's pcb_sched_t. */
+#define STRIDE_SCHED(node) \
+	((pcb_sched_t *)( (char *)(node) - offsetof(pcb_sched_t, tree_node) ))
+
+
+/*! Orders stride_groups by pass (modulo 2^32).
+ *
+ * @private
+ */
+static int stride_compare_groups( rb_node_t *a, rb_node_t *b )
+{
+	long diff = (long)( STRIDE_GROUP(a)->pass - STRIDE_GROUP(b)->pass );
+
+	return diff < 0 ? -1 : diff > 0 ? 1 : 0;
+}
+
+
+/*! Orders a group's tree by pass (modulo 2^32).
+ *
+ * @private
+ */
+static int stride_compare_pcbs( rb_node_t *a, rb_node_t *b )
+{
+	long diff = (long)( STRIDE_SCHED(a)->pass - STRIDE_SCHED(b)->pass );
+
+	return diff < 0 ? -1 : diff > 0 ? 1 : 0;
+}
+
+
+/*! Pass charged for running \c ticks clock ticks, at \c stride per tick;
+ *  at most STRIDE_MAX_REMAIN.
+ *
+ * @private
+ */
+static long stride_charge( unsigned int ticks, unsigned long stride )
+{
+	if ( ticks >= (unsigned long)STRIDE_MAX_REMAIN / stride ){
+		return STRIDE_MAX_REMAIN;
+	}
+	return (long)( ticks * stride );
+}
+
+
+/*! Keeps a remain within STRIDE_MAX_REMAIN either way.
+ *
+ * @private
+ */
+static long stride_clamp( long remain )
+{
+	if ( remain > STRIDE_MAX_REMAIN ){
+		return STRIDE_MAX_REMAIN;
+	}
+	if ( remain < -STRIDE_MAX_REMAIN ){
+		return -STRIDE_MAX_REMAIN;
+	}
+	return remain;
+}
+
+
+/*! Moves stride_min_pass, and a group's min_pass, up to the first pass in
+ *  their trees, if that is ahead.
+ *
+ * @private
+ */
+static void stride_update_min( pcb_group_t *group )
+{
+	rb_node_t *first = rb_first( &stride_groups );
+
+	if ( first != NULL &&
+		(long)( STRIDE_GROUP(first)->pass - stride_min_pass ) > 0 ){
+		stride_min_pass = STRIDE_GROUP(first)->pass;
+	}
+
+	first = rb_first( &group->tree );
+	if ( first != NULL &&
+		(long)( STRIDE_SCHED(first)->pass - group->min_pass ) > 0 ){
+		group->min_pass = STRIDE_SCHED(first)->pass;
+	}
+}
+
+
+/*! Charges a group for clock ticks its processes ran; if it has ready
+ *  PCBs, its run moves to its new place in line, just after the run of
+ *  the group now before it.
+ *
+ * @private
+ */
+static void stride_charge_group(
+	pcb_queue_t	*queue,
+	pcb_group_t	*group,
+	unsigned int	 ticks
+)
+{
+	long		 charge;
+	rb_node_t	*before;
+
+	if ( ticks == 0 ){
+		return;
+	}
+	charge = stride_charge( ticks, STRIDE_ONE / group->weight );
+	if ( group->head == NULL ){
+		group->remain = stride_clamp( group->remain + charge );
+		return;
+	}
+
+	rb_remove( &stride_groups, &group->tree_node );
+	group->pass += (unsigned long)charge;
+	before = rb_insert( &stride_groups, &group->tree_node );
+	move_queue_run( queue, group->head, group->tail,
+		before == NULL ? NULL : STRIDE_GROUP(before)->tail );
+	stride_update_min( group );
+}
+
+
+/*! Puts a PCB whose pass is set into its group's tree, and into the queue's
+ *  list just after the PCB before it in the tree.  If the group had no
+ *  ready PCBs, it goes into stride_groups, placed by its remain; which
+ *  only counts against it if it just ran (\c woken is 0).
+ *
+ * @private
+ */
+static void stride_link( pcb_queue_t *queue, pcb_t *pcb, int woken )
+{
+	pcb_group_t		*group = get_group( pcb->group );
+	pcb_queue_node_t	*node = &pcb->queue_node;
+	rb_node_t		*before;
+
+	if ( group->head == NULL ){
+		/* The group's tree is empty; it is only set up here, so that
+		 * groups may come and go whatever the policy. */
+		rb_init( &group->tree, stride_compare_pcbs );
+		rb_insert( &group->tree, &pcb->sched->tree_node );
+
+		group->pass = stride_min_pass + (unsigned long)
+			( woken && group->remain < 0 ? 0 : group->remain );
+		before = rb_insert( &stride_groups, &group->tree_node );
+		link_queue_node( queue, node,
+			before == NULL ? NULL : STRIDE_GROUP(before)->tail );
+		group->head = node;
+		group->tail = node;
+		stride_update_min( group );
+		return;
+	}
+
+	before = rb_insert( &group->tree, &pcb->sched->tree_node );
+	if ( before == NULL ){
+		link_queue_node( queue, node, group->head->prev );
+		group->head = node;
+	} else {
+		link_queue_node( queue, node,
+			&STRIDE_SCHED(before)->pcb->queue_node );
+		if ( group->tail == &STRIDE_SCHED(before)->pcb->queue_node ){
+			group->tail = node;
+		}
+	}
+	stride_update_min( group );
+}
+
+
+static int stride_start( pcb_queue_t *queue )
+{
+	rb_init( &stride_groups, stride_compare_groups );
+	stride_min_pass = 0;
+	queue->sort_order = POLICY;
+	queue->prio_index = NULL;
+	return 1;
+}
+
+
+/*! A PCB that has become ready is placed as far ahead of its group's least
+ *  pass as it was when it left, but never behind it; likewise its group,
+ *  if the group had no other ready PCBs.
+ */
+static void stride_enqueue( pcb_queue_t *queue, pcb_t *pcb )
+{
+	pcb_sched_t	*sched = pcb->sched;
+	pcb_group_t	*group = get_group( pcb->group );
+
+	sched->pass = group->min_pass +
+		( sched->remain > 0 ? (unsigned long)sched->remain : 0 );
+	stride_link( queue, pcb, 1 );
+}
+
+
+/*! A preempted PCB, and its group, are charged for the ticks it ran, and
+ *  the PCB is placed where it left plus that charge.
+ */
+static void stride_requeue( pcb_queue_t *queue, pcb_t *pcb, unsigned int ticks )
+{
+	pcb_sched_t	*sched = pcb->sched;
+	pcb_group_t	*group = get_group( pcb->group );
+
+	stride_charge_group( queue, group, ticks );
+
+	sched->pass = group->min_pass + (unsigned long)stride_clamp(
+		sched->remain + stride_charge( ticks, STRIDE_ONE ) );
+	stride_link( queue, pcb, 0 );
+}
+
+
+static void stride_remove( pcb_queue_t *queue, pcb_t *pcb )
+{
+	pcb_sched_t		*sched = pcb->sched;
+	pcb_group_t		*group = get_group( pcb->group );
+	pcb_queue_node_t	*node = &pcb->queue_node;
+
+	rb_remove( &group->tree, &sched->tree_node );
+	if ( group->head == node && group->tail == node ){
+		group->head = NULL;
+		group->tail = NULL;
+		rb_remove( &stride_groups, &group->tree_node );
+	} else if ( group->head == node ){
+		group->head = node->next;
+	} else if ( group->tail == node ){
+		group->tail = node->prev;
+	}
+	unlink_queue_node( queue, node );
+	stride_update_min( group );
+
+	sched->remain = stride_clamp( (long)( sched->pass - group->min_pass ) );
+	if ( group->head == NULL ){
+		group->remain = stride_clamp(
+			(long)( group->pass - stride_min_pass ) );
+	}
+}
+
+
+static pcb_t* stride_pick_next( pcb_queue_t *queue )
+{
+	return queue->head == NULL ? NULL : queue->head->pcb;
+}
+
+
+/*! Priority plays no part in this policy. */
+static void stride_change_prio( pcb_queue_t *queue, pcb_t *pcb, int priority )
+{
+	pcb->priority = priority;
+}
+
+
+/*! Checks the trees, and that the queue's list is made up of the groups'
+ *  runs in the same order.
+ */
+static int stride_check( pcb_queue_t *queue )
+{
+	int			 errors = rb_check( &stride_groups );
+	unsigned long		 count = 0;
+	pcb_queue_node_t	*node = queue->head;
+	rb_node_t		*group_node;
+	rb_node_t		*tree_node;
+	pcb_group_t		*group;
+
+	for ( group_node = rb_first( &stride_groups ); group_node != NULL;
+			group_node = rb_next( group_node ) ){
+		group = STRIDE_GROUP(group_node);
+		errors += rb_check( &group->tree );
+		if ( group->tree.count == 0 || group->head != node ){
+			errors++;
+		}
+		for ( tree_node = rb_first( &group->tree ); tree_node != NULL;
+				tree_node = rb_next( tree_node ) ){
+			if ( node == NULL ||
+					STRIDE_SCHED(tree_node)->pcb != node->pcb ){
+				return errors + 1;
+			}
+			if ( rb_next( tree_node ) == NULL && group->tail != node ){
+				errors++;
+			}
+			node = node->next;
+		}
+		count += group->tree.count;
+	}
+	if ( node != NULL || count != queue->length ){
+		errors++;
+	}
+
+	return errors;
+}
+
+
+/*! A PCB that blocks, and its group, are charged for the ticks it ran. */
+static void stride_block( pcb_t *pcb, unsigned int ticks )
+{
+	pcb_group_t *group = get_group( pcb->group );
+
+	stride_charge_group( get_queue_by_state(READY), group, ticks );
+	pcb->sched->remain = stride_clamp( pcb->sched->remain +
+		stride_charge( ticks, STRIDE_ONE ) );
+}
+
+
+/*! The "stride" scheduling policy. */
+sched_policy_t sched_stride = {
+	"stride",
+	"proportional share: CPU split among groups by weight",
+	stride_start,
+	stride_enqueue,
+	stride_requeue,
+	stride_remove,
+	stride_pick_next,
+	stride_change_prio,
+	stride_check,
+	stride_block,
+	NULL,
+	NULL
+};